@@ -0,0 +1,370 @@
+#!/usr/bin/env python3
+"""
+LED Matrix Benchmark
+
+Measures the host side of the frame pipeline and, with a device, the
+whole path to the panel:
+
+  encode  Per workload and wire format (pixel format, run-length coding):
+          encode time per frame, bytes per frame and the packet mix. Every
+          frame is applied to a simulated device frame (the simulator's
+          decoder) and compared with what was encoded.
+  stream  Frames sent for a fixed time: achieved FPS, send latency (until
+          the device's credit report when it paces frames) and, if the
+          firmware answers PKT_STATS, its own frame rate, refresh rate,
+          drops, COBS errors and core loads. With --soak this repeats
+          until Ctrl+C, stopping on the first error.
+
+Usage:
+    led-matrix-bench
+    python -m led_matrix_controller.benchmark
+    python -m led_matrix_controller.benchmark --device serial --seconds 10
+    python -m led_matrix_controller.benchmark --device serial --soak
+"""
+
+import argparse
+import sys
+import time
+from typing import Callable, Dict, List
+
+import numpy as np
+
+try:
+    import cv2
+    HAS_CV2 = True
+except ImportError:
+    HAS_CV2 = False
+
+from .controller import LEDMatrixController, DISPLAY_WIDTH, DISPLAY_HEIGHT
+from .devices import BaseDevice, SerialDevice, USBDevice, CaptureDevice
+from .protocol import (
+    cobs_decode, stats_rates, PKT_FRAME_FULL, PKT_FRAME_ROWS, PKT_FRAME_RECT,
+    PKT_FLAG_RLE,
+)
+
+
+# Wire formats compared by the encode benchmark: (pixel format, compress)
+FORMATS = [
+    ("rgb565", False),
+    ("rgb565", True),
+    ("rgb332", False),
+    ("rgb332", True),
+]
+
+# Source size of the letterbox workload (16:9 video on a 4:1 panel)
+VIDEO_SIZE = (256, 144)
+
+PACKET_NAMES = {
+    PKT_FRAME_FULL: "full",
+    PKT_FRAME_ROWS: "rows",
+    PKT_FRAME_RECT: "rect",
+}
+
+
+# ========================================
+# Workloads
+# ========================================
+
+def workload_noise(index: int, width: int, height: int, rng: np.random.Generator) -> np.ndarray:
+    """Random pixels every frame: nothing to delta or run-length code."""
+    return rng.integers(0, 256, (height, width, 3), dtype=np.uint8)
+
+
+def workload_text(index: int, width: int, height: int, rng: np.random.Generator) -> np.ndarray:
+    """Scrolling text on black: small changes, long runs."""
+    image = np.zeros((height, width, 3), dtype=np.uint8)
+    x = width - (index * 2) % (width * 3)
+    if HAS_CV2:
+        cv2.putText(image, "HUB75 LED MATRIX 12:34:56", (x, height * 3 // 4),
+                    cv2.FONT_HERSHEY_SIMPLEX, height / 40, (255, 200, 0), 2)
+    else:
+        # Blocky "glyphs" without OpenCV
+        for i in range(0, width * 2, 12):
+            gx = x + i
+            if 0 <= gx < width - 8:
+                image[height // 4:height * 3 // 4, gx:gx + 8] = (255, 200, 0)
+    return image
+
+
+def workload_letterbox(index: int, width: int, height: int, rng: np.random.Generator) -> np.ndarray:
+    """Moving 16:9 picture, resized by the controller with black bars."""
+    w, h = VIDEO_SIZE
+    t = index / 30.0
+    x = np.linspace(0, 4 * np.pi, w)[None, :]
+    y = np.linspace(0, 2 * np.pi, h)[:, None]
+    image = np.empty((h, w, 3), dtype=np.uint8)
+    image[:, :, 0] = (127 + 127 * np.sin(x + t)).astype(np.uint8)
+    image[:, :, 1] = (127 + 127 * np.sin(y + t * 1.3)).astype(np.uint8)
+    image[:, :, 2] = (127 + 127 * np.sin(x + y + t * 0.7)).astype(np.uint8)
+    return image
+
+
+WORKLOADS: Dict[str, Callable[[int, int, int, np.random.Generator], np.ndarray]] = {
+    "noise": workload_noise,
+    "text": workload_text,
+    "letterbox": workload_letterbox,
+}
+
+
+# ========================================
+# Encode benchmark (host only)
+# ========================================
+
+def benchmark_encode(
+    workload: str,
+    pixel_format: str,
+    compress: bool,
+    frames: int = 300,
+    width: int = DISPLAY_WIDTH,
+    height: int = DISPLAY_HEIGHT
+) -> dict:
+    """
+    Encode `frames` frames of a workload and check each one decodes.
+
+    Args:
+        workload: Name in WORKLOADS
+        pixel_format: "rgb565" or "rgb332"
+        compress: Run-length code packets when smaller
+        frames: Number of frames
+        width: Display width in pixels
+        height: Display height in pixels
+
+    Returns:
+        encode_ms (mean), encode_p95_ms, bytes (mean encoded bytes per
+        frame), packets (count per packet kind, "+rle" when coded,
+        "unchanged" for frames not sent) and mismatches (frames the
+        simulated device did not end up showing)
+    """
+    device = CaptureDevice(width, height)
+    controller = LEDMatrixController(
+        device, width=width, height=height, pixel_format=pixel_format, compress=compress
+    )
+    device.connect()
+    make = WORKLOADS[workload]
+    rng = np.random.default_rng(0)
+
+    times: List[float] = []
+    sizes: List[int] = []
+    packets: Dict[str, int] = {}
+    mismatches = 0
+    for index in range(frames):
+        image = make(index, width, height, rng)
+
+        start = time.perf_counter()
+        pixels = controller._wire_pixels(image)
+        encoded = controller._encode_pixels(pixels, controller.pixel_format)
+        times.append(time.perf_counter() - start)
+        sizes.append(len(encoded))
+
+        if not encoded:
+            kind = "unchanged"
+        else:
+            packet = cobs_decode(bytes(encoded[:-1])) or b''
+            kind = PACKET_NAMES.get(packet[2] if len(packet) > 2 else -1, "raw")
+            if len(packet) > 3 and packet[3] & PKT_FLAG_RLE:
+                kind += "+rle"
+            device.send(encoded)
+        packets[kind] = packets.get(kind, 0) + 1
+
+        if not np.array_equal(device.frame.pixels, pixels):
+            mismatches += 1
+
+    ms = np.array(times) * 1000
+    return {
+        'encode_ms': float(ms.mean()),
+        'encode_p95_ms': float(np.percentile(ms, 95)),
+        'bytes': float(np.mean(sizes)),
+        'packets': packets,
+        'mismatches': mismatches,
+    }
+
+
+def print_encode_report(workloads: List[str], frames: int):
+    """Run benchmark_encode for every workload and format and print a table."""
+    raw = DISPLAY_WIDTH * DISPLAY_HEIGHT * 2
+    print(f"Encode: {frames} frames per row, {DISPLAY_WIDTH}x{DISPLAY_HEIGHT} "
+          f"(raw RGB565 frame {raw} bytes)")
+    print(f"{'workload':<10} {'format':<11} {'ms/frame':>8} {'p95':>7} "
+          f"{'bytes':>7} {'ratio':>6}  packets")
+    failed = False
+    for workload in workloads:
+        for pixel_format, compress in FORMATS:
+            r = benchmark_encode(workload, pixel_format, compress, frames)
+            name = pixel_format + ("+rle" if compress else "")
+            mix = ", ".join(f"{k} {v}" for k, v in sorted(r['packets'].items()))
+            print(f"{workload:<10} {name:<11} {r['encode_ms']:8.3f} {r['encode_p95_ms']:7.3f} "
+                  f"{r['bytes']:7.0f} {r['bytes'] / raw:6.1%}  {mix}")
+            if r['mismatches']:
+                print(f"  MISMATCH: {r['mismatches']} frames decoded differently")
+                failed = True
+    return not failed
+
+
+# ========================================
+# Stream benchmark (simulator or hardware)
+# ========================================
+
+def benchmark_stream(
+    controller: LEDMatrixController, workload: str, seconds: float = 5.0
+) -> dict:
+    """
+    Send a workload as fast as the device takes it.
+
+    Latency is the time from send_frame() to the credit report covering
+    the frame when the device paces frames, otherwise the send call.
+
+    Args:
+        controller: Connected controller
+        workload: Name in WORKLOADS
+        seconds: Duration
+
+    Returns:
+        fps, latency_ms (mean), latency_p95_ms and device (stats_rates
+        over the run, or None if the firmware does not answer stats queries)
+    """
+    make = WORKLOADS[workload]
+    rng = np.random.default_rng(0)
+    credits = controller._credits
+    before = controller.query_stats()
+
+    latencies: List[float] = []
+    waiting: List[tuple] = []    # (credit sequence, send time)
+    frames = 0
+    start = time.monotonic()
+    while time.monotonic() - start < seconds:
+        image = make(frames, controller.width, controller.height, rng)
+        sent = time.monotonic()
+        if not controller.send_frame(image):
+            raise RuntimeError(f"send failed after {frames} frames")
+        frames += 1
+
+        if credits.enabled:
+            if not waiting or waiting[-1][0] != credits.sent:
+                waiting.append((credits.sent, sent))    # unchanged frames send nothing
+            controller._poll_device()
+            now = time.monotonic()
+            while waiting and ((credits.done - waiting[0][0]) & 0xFFFF) < 0x8000:
+                latencies.append(now - waiting.pop(0)[1])
+        else:
+            latencies.append(time.monotonic() - sent)
+
+    elapsed = time.monotonic() - start
+    after = controller.query_stats()
+    ms = np.array(latencies or [0.0]) * 1000
+    return {
+        'fps': frames / elapsed,
+        'latency_ms': float(ms.mean()),
+        'latency_p95_ms': float(np.percentile(ms, 95)),
+        'device': stats_rates(before, after) if before and after else None,
+    }
+
+
+def print_stream_report(
+    controller: LEDMatrixController, workloads: List[str], seconds: float, soak: bool
+) -> bool:
+    """
+    Run benchmark_stream per workload (repeatedly with soak) and print it.
+
+    Returns:
+        False if the device reported drops or COBS errors
+    """
+    paced = "credit-paced" if controller.flow_control else "unpaced"
+    print(f"\nStream: {seconds:g} s per workload ({paced})")
+    rounds = 0
+    try:
+        while True:
+            rounds += 1
+            for workload in workloads:
+                r = benchmark_stream(controller, workload, seconds)
+                line = (f"{workload:<10} {r['fps']:6.1f} fps  latency {r['latency_ms']:6.2f} ms "
+                        f"(p95 {r['latency_p95_ms']:6.2f})")
+                d = r['device']
+                if d is not None:
+                    line += (f"  device {d['fps']:5.1f} fps refresh {d['refresh_hz']:5.0f} Hz "
+                             f"drop {d['dropped']:.1f}/s cobs {d['cobs_errors']:.1f}/s "
+                             f"core0 {d['decode_load'] + d['convert_load']:4.0%} "
+                             f"core1 idle {d['core1_idle']:4.0%}")
+                print(line)
+                if d is not None and (d['dropped'] or d['cobs_errors']):
+                    print(f"  ERRORS in round {rounds}")
+                    return False
+            if not soak:
+                return True
+    except KeyboardInterrupt:
+        print(f"\nSoak stopped after {rounds} rounds")
+        return True
+
+
+# ========================================
+# Entry point
+# ========================================
+
+def create_device(args) -> BaseDevice:
+    """Device for the stream benchmark."""
+    if args.device == "serial":
+        return SerialDevice(port=args.port)
+    if args.device == "usb":
+        return USBDevice()
+    return CaptureDevice()
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Benchmark and soak test for the LED matrix frame pipeline"
+    )
+    parser.add_argument(
+        "--device", "-d",
+        choices=["simulator", "serial", "usb"],
+        default="simulator",
+        help="Stream target (default: simulator)"
+    )
+    parser.add_argument("--port", "-p", default=None, help="Serial port (auto-detect)")
+    parser.add_argument(
+        "--workload",
+        choices=sorted(WORKLOADS),
+        action="append",
+        help="Workload to run (repeatable, default: all)"
+    )
+    parser.add_argument(
+        "--frames",
+        type=int,
+        default=300,
+        help="Frames per encode measurement (default: 300)"
+    )
+    parser.add_argument(
+        "--seconds",
+        type=float,
+        default=5.0,
+        help="Stream duration per workload (default: 5)"
+    )
+    parser.add_argument(
+        "--format",
+        choices=["rgb565", "rgb332"],
+        default="rgb565",
+        help="Wire pixel format of the stream benchmark (default: rgb565)"
+    )
+    parser.add_argument("--no-compress", action="store_true", help="Stream without RLE")
+    parser.add_argument("--skip-encode", action="store_true", help="Only run the stream benchmark")
+    parser.add_argument("--soak", action="store_true", help="Repeat the stream until Ctrl+C")
+    args = parser.parse_args()
+
+    workloads = args.workload or list(WORKLOADS)
+    ok = True
+    if not args.skip_encode:
+        ok = print_encode_report(workloads, args.frames)
+
+    controller = LEDMatrixController(
+        create_device(args), pixel_format=args.format, compress=not args.no_compress
+    )
+    controller.connect()
+    try:
+        ok = print_stream_report(controller, workloads, args.seconds, args.soak) and ok
+    finally:
+        controller.clear()
+        controller.disconnect()
+
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -7,7 +7,10 @@ and communication with the LED matrix panel.
 
 import time
 import math
-from typing import Tuple, Optional, Union
+import queue
+import threading
+from contextlib import contextmanager
+from typing import Iterable, Tuple, Optional, Union
 from pathlib import Path
 
 import numpy as np
@@ -19,61 +22,246 @@ except ImportError:
     HAS_CV2 = False
 
 from .devices.base import BaseDevice
+from .protocol import (
+    cobs_encode, cobs_encode_into, cobs_max_size, build_delta, build_full_frame,
+    build_palette, build_depth, build_brightness, build_lut, build_credit, build_clock,
+    gamma_lut, rgb_to_rgb332,
+    build_clip_pages, build_clip_save, build_clip_play, encode_clip,
+    build_stats_query, parse_stats, stats_rates, FrameCredits, CLIP_STOP,
+    build_fill, build_sprite, build_blit, build_scroll, build_text,
+    draw_fill, draw_blit, draw_scroll, draw_text,
+    PIXFMT_RGB565, PIXFMT_RGB332, PIXFMT_P8, PIXFMT_P4, FRAME_HEADER_MAX,
+)
+from .font import FONT_CELL_WIDTH, FONT_CELL_HEIGHT
 
 
 # Display configuration
 DISPLAY_WIDTH = 128
 DISPLAY_HEIGHT = 32
 
-# Maximum FPS for video playback (internal limit)
+# Maximum FPS for video playback without flow control (firmware that
+# does not report credits); with credits the device paces playback
 MAX_VIDEO_FPS = 18
 
+# Seconds to wait for the credit reply on connect
+CREDIT_PROBE_TIMEOUT = 0.2
 
-def cobs_encode(data: bytes) -> bytes:
+# Seconds to wait for the reply to a stats query
+STATS_TIMEOUT = 0.5
+
+# Send a full frame at least this often, even when deltas would be smaller
+KEYFRAME_INTERVAL = 60
+
+# Seconds between clock packets (keeps the device's copy of the host clock
+# from drifting)
+CLOCK_SYNC_INTERVAL = 1.0
+
+# Clip stream bytes per flash slot (firmware env pico_clips: 1 MB split
+# into 4 slots, less each slot's header page)
+CLIP_CAPACITY = 256 * 1024 - 256
+
+# Video frames are timestamped this far ahead of their ideal time so they
+# reach the device before their flip
+PRESENTATION_DELAY = 0.05
+
+# Wire pixel formats selectable for RGB images
+PIXEL_FORMATS = {
+    "rgb565": PIXFMT_RGB565,
+    "rgb332": PIXFMT_RGB332,
+}
+
+
+class FrameEncoder:
     """
-    Encode data using COBS (Consistent Overhead Byte Stuffing).
+    Background thread that delta/COBS-encodes frames one at a time.
+
+    The controller hands it a frame and, while it is being encoded, writes
+    the previous frame's packet to the device, so encoding overlaps the
+    serial writes and credit waits. Frames are encoded in submission order
+    by a single worker, so the delta state stays consistent.
+    """
+
+    def __init__(self, encode):
+        """
+        Args:
+            encode: Function (pixels, fmt, pts, out) -> encoded packet bytes
+        """
+        self._encode = encode
+        self._jobs: queue.Queue = queue.Queue(maxsize=1)
+        self._results: queue.Queue = queue.Queue(maxsize=1)
+        self._busy = False
+        self._thread = threading.Thread(target=self._run, daemon=True)
+        self._thread.start()
+
+    def _run(self):
+        while True:
+            job = self._jobs.get()
+            if job is None:
+                return
+            try:
+                result = self._encode(*job)
+            except Exception as e:    # re-raised by take()
+                result = e
+            self._results.put((job, result))
+
+    def submit(
+        self, pixels: np.ndarray, fmt: int, pts: Optional[int],
+        out: Optional[np.ndarray] = None
+    ):
+        """Start encoding a frame (the previous one must have been taken)."""
+        self._busy = True
+        self._jobs.put((pixels, fmt, pts, out))
+
+    def take(self) -> Optional[tuple]:
+        """
+        Wait for the frame being encoded.
+
+        Returns:
+            ((pixels, fmt, pts, out), encoded bytes), or None if nothing was submitted
+        """
+        if not self._busy:
+            return None
+        self._busy = False
+        job, result = self._results.get()
+        if isinstance(result, Exception):
+            raise result
+        return job, result
+
+    def close(self):
+        """Stop the worker (take() the pending frame first)."""
+        self._jobs.put(None)
+        self._thread.join()
 
-    COBS removes all zero bytes from the data stream, replacing them
-    with overhead codes. The packet is terminated with a zero byte.
 
-    Args:
-        data: Input data to encode
+class VideoBuffers:
+    """
+    Preallocated buffers for streaming a video (play_video).
+
+    Every stage of a frame reuses its array: OpenCV decodes into `decoded`,
+    resizes into a fixed letterbox canvas, the wire pixels are computed
+    in place into a ring of slots and the COBS packet is written into a
+    reused output buffer. Nothing is allocated per frame apart from the
+    small index arrays of the encoder, which keeps long playback free of
+    allocator and GC jitter.
 
-    Returns:
-        COBS-encoded data (does not include terminating 0x00)
+    Pixel slots are reused in turn; there are enough that the controller's
+    delta reference, a frame held by the FrameEncoder and the frame being
+    prepared never share one. The same holds for the two packet buffers
+    (one being encoded, one being written).
     """
-    if not data:
-        return b'\x01'  # Empty packet
-
-    output = bytearray()
-    code_index = 0
-    code = 1
-
-    output.append(0)  # Placeholder for first code
-
-    for byte in data:
-        if byte == 0:
-            # Found zero - write code and start new segment
-            output[code_index] = code
-            code_index = len(output)
-            output.append(0)  # Placeholder for next code
-            code = 1
+
+    PIXEL_SLOTS = 3
+    PACKET_SLOTS = 2
+
+    def __init__(self, width: int, height: int, pixel_format: int):
+        """
+        Args:
+            width: Display width in pixels
+            height: Display height in pixels
+            pixel_format: Wire format (PIXFMT_RGB565 or PIXFMT_RGB332)
+        """
+        self.width = width
+        self.height = height
+        self.pixel_format = pixel_format
+
+        # Decoded BGR frame (source size), allocated by the first read
+        self.decoded: Optional[np.ndarray] = None
+
+        # Letterbox layout for the current source size
+        self._source: Optional[Tuple[int, int]] = None
+        self._scaled: Optional[np.ndarray] = None
+        self._window: Optional[np.ndarray] = None
+        self._canvas = np.zeros((height, width, 3), dtype=np.uint8)
+
+        dtype = np.uint8 if pixel_format == PIXFMT_RGB332 else np.uint16
+        self._pixels = [np.empty((height, width), dtype=dtype)
+                        for _ in range(self.PIXEL_SLOTS)]
+        self._scratch = np.empty((height, width), dtype=dtype)
+        self._next_pixels = 0
+
+        # Largest frame packet: header, pts, raw pixels and the pad byte
+        packet_max = FRAME_HEADER_MAX + width * height * 2 + 1
+        self._packets = [np.empty(cobs_max_size(packet_max) + 1, dtype=np.uint8)
+                         for _ in range(self.PACKET_SLOTS)]
+        self._next_packet = 0
+
+    def read(self, cap) -> bool:
+        """Decode the next frame of an OpenCV capture into `decoded`."""
+        ret, frame = cap.read(self.decoded)
+        if ret:
+            self.decoded = frame
+        return ret
+
+    def _layout(self, h: int, w: int):
+        """Letterbox placement of an h x w source (as _resize_image "fit")."""
+        self._source = (h, w)
+        self._canvas[:] = 0
+        scale = min(self.width / w, self.height / h)
+        new_w, new_h = int(w * scale), int(h * scale)
+        x = (self.width - new_w) // 2
+        y = (self.height - new_h) // 2
+        self._window = self._canvas[y:y + new_h, x:x + new_w]
+        self._scaled = None
+        if (new_h, new_w) != (self.height, self.width):
+            self._scaled = np.empty((new_h, new_w, 3), dtype=np.uint8)
+
+    def wire_pixels(self, bgr: np.ndarray) -> np.ndarray:
+        """
+        Decoded BGR frame -> display-sized pixels in wire layout and format.
+
+        Returns:
+            The next pixel slot (valid until it comes round again)
+        """
+        h, w = bgr.shape[:2]
+        if self._source != (h, w):
+            self._layout(h, w)
+
+        if (h, w) == (self.height, self.width):
+            np.copyto(self._canvas, bgr)
+        elif self._scaled is None:
+            cv2.resize(bgr, (self.width, self.height), dst=self._canvas,
+                       interpolation=cv2.INTER_AREA)
+        else:
+            cv2.resize(bgr, self._scaled.shape[1::-1], dst=self._scaled,
+                       interpolation=cv2.INTER_AREA)
+            np.copyto(self._window, self._scaled)
+
+        # Horizontal flip for HUB75 shift order, channels in BGR order
+        flipped = self._canvas[:, ::-1]
+        pixels = self._pixels[self._next_pixels]
+        self._next_pixels = (self._next_pixels + 1) % self.PIXEL_SLOTS
+        t = self._scratch
+
+        np.copyto(pixels, flipped[:, :, 2])
+        np.copyto(t, flipped[:, :, 1])
+        if self.pixel_format == PIXFMT_RGB332:
+            pixels &= 0xE0
+            t >>= 3
+            t &= 0x1C
+            pixels |= t
+            np.copyto(t, flipped[:, :, 0])
+            t >>= 6
         else:
-            # Copy non-zero byte
-            output.append(byte)
-            code += 1
+            pixels >>= 3
+            pixels <<= 11
+            t >>= 2
+            t <<= 5
+            pixels |= t
+            np.copyto(t, flipped[:, :, 0])
+            t >>= 3
+        pixels |= t
+        return pixels
 
-            if code == 0xFF:
-                # Segment full (254 bytes) - write code and start new segment
-                output[code_index] = code
-                code_index = len(output)
-                output.append(0)  # Placeholder for next code
-                code = 1
+    def packet_buffer(self) -> np.ndarray:
+        """Next output buffer for an encoded frame packet."""
+        out = self._packets[self._next_packet]
+        self._next_packet = (self._next_packet + 1) % self.PACKET_SLOTS
+        return out
 
-    # Write final code
-    output[code_index] = code
 
-    return bytes(output)
+def host_time_us() -> int:
+    """Host clock for presentation timestamps: monotonic microseconds, 32-bit."""
+    return (time.monotonic_ns() // 1000) & 0xFFFFFFFF
 
 
 class LEDMatrixController:
@@ -84,7 +272,10 @@ class LEDMatrixController:
         device: BaseDevice,
         width: int = DISPLAY_WIDTH,
         height: int = DISPLAY_HEIGHT,
-        brightness: float = 1.0
+        brightness: float = 1.0,
+        pixel_format: str = "rgb565",
+        compress: bool = True,
+        pipeline: bool = False
     ):
         """
         Initialize controller.
@@ -93,32 +284,136 @@ class LEDMatrixController:
             device: Output device (SerialDevice, TerminalDevice, etc.)
             width: Display width in pixels
             height: Display height in pixels
-            brightness: Brightness multiplier (0.0-1.0)
+            brightness: Display brightness (0.0-1.0), applied by the firmware
+            pixel_format: Wire format for RGB images ("rgb565" or "rgb332")
+            compress: Run-length code frame packets when that makes them
+                      smaller (flat backgrounds, text, letterboxing)
+            pipeline: Encode video and demo frames on a background thread
+                      while the previous frame is being written (FrameEncoder)
         """
+        if pixel_format not in PIXEL_FORMATS:
+            raise ValueError(f"Unknown pixel format: {pixel_format}")
+
         self.device = device
         self.width = width
         self.height = height
         self.brightness = max(0.0, min(1.0, brightness))
+        self.pixel_format = PIXEL_FORMATS[pixel_format]
+        self.compress = compress
+        self.pipeline = pipeline
 
         # FPS tracking
         self._frame_count = 0
         self._fps_start = time.time()
         self._current_fps = 0.0
+
+        # Delta encoding state: last frame sent to the device and its format
+        self._last_pixels: Optional[np.ndarray] = None
+        self._last_format = PIXFMT_RGB565
+        self._frames_since_key = 0
+
+        # Sprites uploaded to the device: slot -> (format, wire pixels)
+        self._sprites = {}
+
+        # Pipelined encoding (streaming(), pipeline=True): worker thread and
+        # whether the frame it holds must be re-encoded in full
+        self._encoder: Optional[FrameEncoder] = None
+        self._resync = False
+
+        # Flow control: frame packets in flight vs the device's window
+        self._credits = FrameCredits()
+
+        # Last PKT_STATS reply (parse_stats), None until one arrives
+        self._stats: Optional[dict] = None
+
+        # Last clock packet (time.monotonic), 0 if never sent
+        self._clock_sent = 0.0
     
-    def connect(self) -> bool:
-        """Connect to the device."""
-        return self.device.connect()
+    def connect(self, configure: bool = True) -> bool:
+        """
+        Connect to the device, start flow control if the firmware supports
+        it, share the host clock and apply the configured brightness.
+
+        Args:
+            configure: False to only open the device, leaving whatever it
+                       shows untouched (monitoring a running panel)
+        """
+        self._last_pixels = None
+        if not self.device.connect():
+            return False
+        if not configure:
+            return True
+        self._start_flow_control()
+        self.sync_clock()
+        return self.set_brightness(self.brightness)
+
+    def sync_clock(self) -> bool:
+        """
+        Send the current host time, the reference for presentation timestamps.
+        Called on connect and, while frames are sent, every CLOCK_SYNC_INTERVAL.
+        """
+        self._clock_sent = time.monotonic()
+        packet = build_clock(host_time_us(), self.width * self.height * 2)
+        return self.device.send(cobs_encode(packet) + b'\x00')
+
+    def _send_credit_probe(self) -> bool:
+        """Reset the device's frame count; it answers with a credit report."""
+        self._credits.reset()
+        packet = build_credit(0, self.width * self.height * 2)
+        return self.device.send(cobs_encode(packet) + b'\x00')
+
+    def _start_flow_control(self):
+        """Reset the device's frame count and wait briefly for its report."""
+        if not self._send_credit_probe():
+            return
+        deadline = time.monotonic() + CREDIT_PROBE_TIMEOUT
+        while not self._credits.enabled and time.monotonic() < deadline:
+            self._poll_device()
+            time.sleep(0.001)
+
+    @property
+    def flow_control(self) -> bool:
+        """True if the device paces frames with credit reports."""
+        return self._credits.enabled
+
+    def _poll_device(self):
+        """Read what the device sent: credit reports and stats replies."""
+        for packet in self._credits.feed(self.device.receive()):
+            stats = parse_stats(packet)
+            if stats is not None:
+                self._stats = stats
+
+    def _wait_for_credit(self):
+        """Block until the device has room for another frame packet."""
+        self._poll_device()
+        while not self._credits.can_send():
+            if self._credits.stalled:
+                # Counts out of step (lost report, dropped packet): start over
+                self._send_credit_probe()
+                break
+            time.sleep(0.0005)
+            self._poll_device()
+
+    def _send_frame_packet(self, encoded: bytes, wait_ack: bool = True) -> bool:
+        """Send one encoded frame packet once a credit is available."""
+        if time.monotonic() - self._clock_sent >= CLOCK_SYNC_INTERVAL:
+            self.sync_clock()
+        self._wait_for_credit()
+        result = self.device.send(encoded, wait_ack=wait_ack)
+
+        if result:
+            self._credits.on_sent()
+            self._update_fps()
+        else:
+            # Device state unknown: next frame goes out in full
+            self._last_pixels = None
+
+        return result
     
     def disconnect(self):
         """Disconnect from the device."""
         self.device.disconnect()
     
-    def _apply_brightness(self, image: np.ndarray) -> np.ndarray:
-        """Apply brightness adjustment."""
-        if self.brightness < 1.0:
-            return (image * self.brightness).astype(np.uint8)
-        return image
-    
     def _resize_image(self, image: np.ndarray, fit_mode: str = "fit") -> np.ndarray:
         """
         Resize image to display dimensions with aspect ratio preservation.
@@ -181,35 +476,55 @@ class LEDMatrixController:
         b = (image[:, :, 2] >> 3).astype(np.uint16)
         return (r << 11) | (g << 5) | b
     
-    def _encode_frame(self, image: np.ndarray) -> bytes:
-        """
-        Encode image for transmission using COBS.
-
-        Args:
-            image: RGB image (H, W, 3) uint8
-
-        Returns:
-            COBS-encoded bytes with 0x00 terminator
-        """
+    def _wire_pixels(self, image: np.ndarray) -> np.ndarray:
+        """RGB image (any size) -> display-sized pixels in wire layout and format."""
         # Resize to display dimensions
         if image.shape[:2] != (self.height, self.width):
             image = self._resize_image(image)
 
-        # Apply brightness
-        image = self._apply_brightness(image)
-
         # Horizontal flip for HUB75 shift register order
         # Data is shifted right-to-left, last pixel shifted stays at left edge
         image = np.fliplr(image)
 
-        # Convert to RGB565
-        rgb565 = self._rgb_to_rgb565(image)
+        # Convert to the wire pixel format
+        if self.pixel_format == PIXFMT_RGB332:
+            return rgb_to_rgb332(image)
+        return self._rgb_to_rgb565(image)
 
-        # Convert to bytes (little-endian)
-        data = rgb565.astype('<u2').tobytes()
+    def _encode_pixels(
+        self, pixels: np.ndarray, fmt: int, pts: Optional[int] = None,
+        out: Optional[np.ndarray] = None
+    ) -> bytes:
+        """
+        Delta-encode a frame already in wire layout (flipped) and format.
+
+        Args:
+            out: Reused uint8 buffer to encode into (VideoBuffers), or None
+
+        Returns:
+            COBS-encoded bytes with 0x00 terminator (a view of `out` if
+            given), or b'' if nothing changed
+        """
+        # Diff against the last frame sent; periodic keyframe for resync
+        previous = self._last_pixels if fmt == self._last_format else None
+        self._frames_since_key += 1
+        if self._frames_since_key >= KEYFRAME_INTERVAL:
+            self._frames_since_key = 0
+            packet = build_full_frame(pixels, fmt, pts, self.compress)
+        else:
+            packet = build_delta(pixels, previous, fmt, pts, self.compress)
+        self._last_pixels = pixels
+        self._last_format = fmt
+
+        if packet is None:
+            return b''
 
         # COBS encode and add 0x00 terminator
-        encoded = cobs_encode(data)
+        if out is not None:
+            length = cobs_encode_into(packet, out)
+            out[length] = 0
+            return memoryview(out)[:length + 1]
+        encoded = cobs_encode(packet)
         return encoded + b'\x00'
     
     def _update_fps(self):
@@ -226,25 +541,553 @@ class LEDMatrixController:
         """Get current FPS."""
         return self._current_fps
     
-    def send_frame(self, image: np.ndarray, wait_ack: bool = True) -> bool:
+    def send_frame(
+        self, image: np.ndarray, wait_ack: bool = True, pts: Optional[int] = None
+    ) -> bool:
         """
         Send a frame to the display.
 
+        With flow control this waits until the device has a free frame slot.
+
         Args:
             image: RGB image (any size, will be resized)
             wait_ack: Ignored (kept for compatibility)
+            pts: Host time (host_time_us()) at which the device should flip
+                 to this frame, or None to show it as soon as it is converted
 
         Returns:
             True if successful
         """
-        encoded = self._encode_frame(image)
-        result = self.device.send(encoded, wait_ack=wait_ack)
-        
-        if result:
+        # Resized/converted here, while an encoder thread (if any) encodes
+        # the previous frame
+        return self._send_pixels(self._wire_pixels(image), pts, wait_ack)
+
+    def _send_pixels(
+        self, pixels: np.ndarray, pts: Optional[int] = None, wait_ack: bool = True,
+        out: Optional[np.ndarray] = None
+    ) -> bool:
+        """Send a frame in wire layout and format (see send_frame)."""
+        if self._encoder is not None:
+            pending = self._take_encoded()
+            self._encoder.submit(pixels, self.pixel_format, pts, out)
+            if pending is None:
+                return True
+            return self._send_encoded(pending, wait_ack)
+
+        encoded = self._encode_pixels(pixels, self.pixel_format, pts, out)
+        return self._send_encoded(encoded, wait_ack)
+
+    def _send_encoded(self, encoded: bytes, wait_ack: bool = True) -> bool:
+        """Send an encoded frame packet; b'' (unchanged frame) sends nothing."""
+        if not encoded:
+            # Unchanged frame: nothing to send
             self._update_fps()
-        
+            return True
+
+        result = self._send_frame_packet(encoded, wait_ack=wait_ack)
+        if not result and self._encoder is not None:
+            # The frame being encoded is a delta against state the device
+            # may not have
+            self._resync = True
         return result
+
+    def _take_encoded(self) -> Optional[bytes]:
+        """Packet of the frame the worker holds, or None if it holds none."""
+        pending = self._encoder.take()
+        if pending is None:
+            return None
+        job, encoded = pending
+        if self._resync:
+            # Worker is idle: re-encode in full on this thread
+            self._resync = False
+            self._last_pixels = None
+            encoded = self._encode_pixels(*job)
+        return encoded
+
+    @contextmanager
+    def streaming(self):
+        """
+        Pipelined sends for a run of frames (video, demos), if enabled.
+
+        Inside the block send_frame() returns once the frame is handed to
+        the encoder thread and writes the previous one; the last frame is
+        sent on exit. Without pipeline=True this does nothing.
+        """
+        if not self.pipeline or self._encoder is not None:
+            yield
+            return
+
+        self._encoder = FrameEncoder(self._encode_pixels)
+        try:
+            yield
+        finally:
+            try:
+                pending = self._take_encoded()
+                if pending is not None:
+                    self._send_encoded(pending)
+            finally:
+                self._encoder.close()
+                self._encoder = None
+                self._resync = False
+
+    def set_palette(self, colors: np.ndarray, first: int = 0) -> bool:
+        """
+        Upload palette entries used by send_indexed().
+
+        Args:
+            colors: (N, 3) uint8 RGB colours
+            first: First palette index to set
+
+        Returns:
+            True if successful
+        """
+        packet = build_palette(colors, first, self.width * self.height * 2)
+        return self.device.send(cobs_encode(packet) + b'\x00')
+
+    def set_brightness(self, brightness: float) -> bool:
+        """
+        Set the display brightness in firmware.
+
+        The firmware shortens the OE on-time of every bit plane, so pixel
+        values (and colour depth) are left untouched.
+
+        Args:
+            brightness: 0.0 (off) to 1.0 (full)
+
+        Returns:
+            True if successful
+        """
+        self.brightness = max(0.0, min(1.0, brightness))
+        level = int(round(self.brightness * 255))
+        packet = build_brightness(level, self.width * self.height * 2)
+        return self.device.send(cobs_encode(packet) + b'\x00')
+
+    def set_lut(self, channel: int, levels: np.ndarray) -> bool:
+        """
+        Upload one channel's RGB565 curve (replaces the firmware gamma).
+
+        Args:
+            channel: 0 = R, 1 = G, 2 = B
+            levels: 32 (R/B) or 64 (G) linear levels, 0-65535
+
+        Returns:
+            True if successful
+        """
+        packet = build_lut(channel, levels, self.width * self.height * 2)
+        return self.device.send(cobs_encode(packet) + b'\x00')
+
+    def set_gamma(
+        self, gamma: float = 2.2, gains: Tuple[float, float, float] = (1.0, 1.0, 1.0)
+    ) -> bool:
+        """
+        Upload power-law curves for all channels, with per-channel gain
+        for white balance.
+
+        Args:
+            gamma: Curve exponent
+            gains: R, G, B output scale 0.0-1.0
+
+        Returns:
+            True if successful
+        """
+        return all(
+            self.set_lut(channel, gamma_lut(channel, gamma, gains[channel]))
+            for channel in range(3)
+        )
+
+    def set_depth(self, depth: int) -> bool:
+        """
+        Set the display colour depth (bits per channel).
+
+        Lower depths refresh faster; the firmware rejects depths above its
+        build-time COLOR_DEPTH.
+
+        Args:
+            depth: 4, 6, 8 or 10
+
+        Returns:
+            True if successful
+        """
+        packet = build_depth(depth, self.width * self.height * 2)
+        return self.device.send(cobs_encode(packet) + b'\x00')
+
+    def send_indexed(
+        self, indices: np.ndarray, bits: int = 8, pts: Optional[int] = None
+    ) -> bool:
+        """
+        Send a paletted frame (display-sized, display orientation).
+
+        Args:
+            indices: (H, W) uint8 palette indices (0-15 when bits is 4)
+            bits: 8 for P8, 4 for P4
+            pts: Presentation time as for send_frame(), or None
+
+        Returns:
+            True if successful
+        """
+        if indices.shape != (self.height, self.width):
+            raise ValueError(f"Indexed frame must be {self.width}x{self.height}")
+        fmt = PIXFMT_P4 if bits == 4 else PIXFMT_P8
+
+        # Horizontal flip for HUB75 shift register order
+        encoded = self._encode_pixels(np.fliplr(indices).copy(), fmt, pts)
+        if not encoded:
+            self._update_fps()
+            return True
+
+        return self._send_frame_packet(encoded)
     
+    # ========================================
+    # Drawing (executed by the firmware)
+    # ========================================
+    # Each call sends a few bytes instead of pixels. Coordinates are display
+    # coordinates; colours are RGB tuples (or raw pixel values) for RGB565 /
+    # RGB332 frames and palette indices for indexed ones. Drawing applies to
+    # the format of the last frame sent; inside streaming() the frame being
+    # encoded is sent first.
+
+    def _draw_color(self, color: Union[int, Tuple[int, int, int]]) -> int:
+        """Pixel value of a colour in the device's current format."""
+        if isinstance(color, (int, np.integer)):
+            return int(color)
+        rgb = np.array(color, dtype=np.uint8).reshape(1, 1, 3)
+        if self._last_format == PIXFMT_RGB332:
+            return int(rgb_to_rgb332(rgb)[0, 0])
+        if self._last_format == PIXFMT_RGB565:
+            return int(self._rgb_to_rgb565(rgb)[0, 0])
+        raise ValueError("Indexed frames are drawn with palette indices")
+
+    def _flush_encoder(self) -> bool:
+        """
+        Send the frame the encoder thread holds (inside streaming()), so a
+        drawing packet follows it and is built on settled delta state.
+
+        Returns:
+            False if that frame could not be sent
+        """
+        if self._encoder is None:
+            return True
+        pending = self._take_encoded()
+        return pending is None or self._send_encoded(pending)
+
+    def _send_draw(self, packet: bytes, draw) -> bool:
+        """
+        Send a drawing packet (paced like a frame) and apply the same change
+        to the copy of the device frame that deltas are encoded against.
+
+        Args:
+            packet: Drawing packet (not COBS-encoded)
+            draw: Function applying the change to wire-layout pixels
+        """
+        if not self._send_frame_packet(cobs_encode(packet) + b'\x00'):
+            return False
+        if self._last_pixels is not None:
+            # May be a frame the caller still owns (VideoBuffers): draw on a copy
+            self._last_pixels = self._last_pixels.copy()
+            draw(self._last_pixels)
+        return True
+
+    def fill_rect(
+        self, x: int, y: int, width: int, height: int,
+        color: Union[int, Tuple[int, int, int]]
+    ) -> bool:
+        """Fill a rectangle inside the display."""
+        if not self._flush_encoder():
+            return False
+        value = self._draw_color(color)
+        fmt = self._last_format
+        packet = build_fill(x, y, width, height, value, fmt,
+                            frame_size=self.width * self.height * 2)
+        if (width, height) == (self.width, self.height) and self._last_pixels is None:
+            # The whole frame is known again
+            dtype = np.uint16 if fmt == PIXFMT_RGB565 else np.uint8
+            self._last_pixels = np.zeros((self.height, self.width), dtype=dtype)
+        return self._send_draw(
+            packet, lambda pixels: draw_fill(pixels, x, y, width, height, value))
+
+    def upload_sprite(self, slot: int, image: np.ndarray) -> bool:
+        """
+        Store a sprite on the device for blit(), in the current format.
+
+        Args:
+            slot: Sprite slot (0 to SPRITE_SLOTS - 1)
+            image: (h, w, 3) RGB image, or (h, w) palette indices for
+                   indexed frames, display orientation; at most
+                   SPRITE_BYTES of pixels
+
+        Returns:
+            True if successful
+        """
+        if not self._flush_encoder():
+            return False
+        fmt = self._last_format
+        if image.ndim == 3:
+            self._draw_color((0, 0, 0))  # Raises for indexed frames
+            flipped = np.fliplr(image)
+            if fmt == PIXFMT_RGB332:
+                pixels = rgb_to_rgb332(flipped)
+            else:
+                pixels = self._rgb_to_rgb565(flipped)
+        else:
+            pixels = np.fliplr(image).astype(np.uint8)
+
+        packet = build_sprite(slot, pixels, fmt, self.compress, self.width * self.height * 2)
+        if not self.device.send(cobs_encode(packet) + b'\x00'):
+            self._sprites.pop(slot, None)
+            return False
+        self._sprites[slot] = (fmt, pixels)
+        return True
+
+    def blit(
+        self, slot: int, x: int, y: int,
+        key: Optional[Union[int, Tuple[int, int, int]]] = None
+    ) -> bool:
+        """
+        Draw an uploaded sprite with its top left at (x, y); it may lie
+        partly off the display.
+
+        Args:
+            slot: Sprite slot given to upload_sprite()
+            x, y: Position
+            key: Transparent colour (pixels of this colour are skipped), or None
+        """
+        if not self._flush_encoder():
+            return False
+        sprite = self._sprites.get(slot)
+        if sprite is None or sprite[0] != self._last_format:
+            raise ValueError(f"Sprite {slot} has not been uploaded in the current format")
+        value = self._draw_color(key) if key is not None else None
+        packet = build_blit(slot, x, y, value, self._last_format,
+                            frame_size=self.width * self.height * 2)
+        return self._send_draw(
+            packet, lambda pixels: draw_blit(pixels, sprite[1], x, y, value))
+
+    def scroll(
+        self, dx: int, dy: int = 0, rect: Optional[Tuple[int, int, int, int]] = None
+    ) -> bool:
+        """
+        Move the content dx pixels right and dy down (negative: left / up),
+        wrapping around.
+
+        Args:
+            dx, dy: Shift in pixels
+            rect: (x, y, width, height) to scroll, or None for the whole display
+        """
+        if not self._flush_encoder():
+            return False
+        x, y, width, height = rect if rect is not None else (0, 0, self.width, self.height)
+        packet = build_scroll(x, y, width, height, dx, dy, self._last_format,
+                              frame_size=self.width * self.height * 2)
+        return self._send_draw(
+            packet, lambda pixels: draw_scroll(pixels, x, y, width, height, dx, dy))
+
+    def draw_text(
+        self, x: int, y: int, text: str,
+        color: Union[int, Tuple[int, int, int]] = (255, 255, 255),
+        background: Optional[Union[int, Tuple[int, int, int]]] = None
+    ) -> bool:
+        """
+        Draw text in the firmware's 5x7 font (6x8 pixel cells, see font.py).
+
+        Args:
+            x, y: Top left of the first cell
+            text: 1-255 ASCII characters
+            color: Colour of the dots
+            background: Colour of the rest of the cells, or None to leave it
+        """
+        if not self._flush_encoder():
+            return False
+        value = self._draw_color(color)
+        fill = self._draw_color(background) if background is not None else None
+        packet = build_text(x, y, text, value, fill, self._last_format,
+                            frame_size=self.width * self.height * 2)
+        data = text.encode('ascii', errors='replace')
+        return self._send_draw(
+            packet, lambda pixels: draw_text(pixels, x, y, data, value, fill))
+
+    def run_ticker(
+        self, text: str, fps: float = 30.0,
+        color: Tuple[int, int, int] = (255, 255, 255)
+    ):
+        """
+        Scroll a line of text across the display, one pixel per frame.
+
+        The text is drawn once; every frame after that is one scroll packet
+        of a few bytes, wrapping the line around, so the text must fit the
+        display width.
+        """
+        if len(text) * FONT_CELL_WIDTH > self.width:
+            raise ValueError(f"Ticker text fits {self.width // FONT_CELL_WIDTH} characters")
+        y = (self.height - FONT_CELL_HEIGHT) // 2
+        band = (0, y, self.width, FONT_CELL_HEIGHT)
+
+        self.fill_rect(0, 0, self.width, self.height, (0, 0, 0))
+        self.draw_text((self.width - len(text) * FONT_CELL_WIDTH) // 2, y, text, color)
+
+        print(f"Ticker: {text}")
+        print("Press Ctrl+C to stop")
+
+        frame_time = 1.0 / fps
+        try:
+            while True:
+                start = time.time()
+                self.scroll(-1, 0, band)
+
+                elapsed = time.time() - start
+                if elapsed < frame_time:
+                    time.sleep(frame_time - elapsed)
+
+                if self._frame_count == 0:
+                    print(f"\rFPS: {self.fps:.1f}  ", end='', flush=True)
+
+        except KeyboardInterrupt:
+            print()
+
+    # ========================================
+    # Flash Clips (firmware env: pico_clips)
+    # ========================================
+
+    def upload_clip(
+        self,
+        frames: Iterable[np.ndarray],
+        slot: int = 0,
+        fps: float = 30.0,
+        autoplay: bool = False,
+        capacity: int = CLIP_CAPACITY
+    ) -> int:
+        """
+        Store an animation in the device's flash for local playback.
+
+        Frames are delta-encoded (and run-length coded) in the configured
+        pixel format (rgb332 roughly doubles what fits) and recorded until
+        the slot is full.
+
+        Args:
+            frames: RGB images (any size, will be resized), read lazily
+            slot: Flash slot (0 to CLIP_SLOTS - 1 of the firmware)
+            fps: Playback rate
+            autoplay: Play this clip whenever the device boots
+            capacity: Stream bytes per slot
+
+        Returns:
+            Number of frames stored (0 on failure)
+        """
+        wire = (self._wire_pixels(image) for image in frames)
+        stream, count = encode_clip(wire, self.pixel_format, capacity, self.compress)
+        if count == 0:
+            return 0
+
+        frame_size = self.width * self.height * 2
+        for packet in build_clip_pages(slot, stream, frame_size):
+            if not self.device.send(cobs_encode(packet) + b'\x00'):
+                return 0
+        interval_ms = max(1, min(0xFFFF, round(1000 / fps)))
+        packet = build_clip_save(slot, len(stream), interval_ms, autoplay, frame_size)
+        if not self.device.send(cobs_encode(packet) + b'\x00'):
+            return 0
+        return count
+
+    def play_clip(self, slot: int) -> bool:
+        """
+        Loop a stored clip on the device; it keeps playing without the host
+        until stop_clip() or the next frame sent.
+        """
+        # The clip overwrites the device's frame: next frame goes out in full
+        self._last_pixels = None
+        packet = build_clip_play(slot, self.width * self.height * 2)
+        return self.device.send(cobs_encode(packet) + b'\x00')
+
+    def stop_clip(self) -> bool:
+        """Stop clip playback (the last clip frame stays up)."""
+        return self.play_clip(CLIP_STOP)
+
+    def query_stats(self) -> Optional[dict]:
+        """
+        Read the device's performance counters.
+
+        Returns:
+            parse_stats() result, or None if the firmware did not answer
+            within STATS_TIMEOUT (older firmware, simulators)
+        """
+        self._stats = None
+        packet = build_stats_query(self.width * self.height * 2)
+        if not self.device.send(cobs_encode(packet) + b'\x00'):
+            return None
+        deadline = time.monotonic() + STATS_TIMEOUT
+        while self._stats is None and time.monotonic() < deadline:
+            self._poll_device()
+            time.sleep(0.001)
+        return self._stats
+
+    def monitor_stats(self, interval: float = 1.0):
+        """Print the device's rates and loads every interval until Ctrl+C."""
+        prev = self.query_stats()
+        if prev is None:
+            raise RuntimeError("Device does not answer stats queries")
+
+        print(f"clk_sys {prev['clk_mhz']} MHz, {prev['depth']}-bit colour")
+        print("Press Ctrl+C to stop")
+        try:
+            while True:
+                time.sleep(interval)
+                cur = self.query_stats()
+                if cur is None:
+                    print("\nNo reply")
+                    continue
+                r = stats_rates(prev, cur)
+                print(f"\rrx {r['rx_kbps']:7.0f} kbit/s  {r['fps']:5.1f} fps  "
+                      f"refresh {r['refresh_hz']:6.0f} Hz  "
+                      f"drop {r['dropped']:.0f}/s  cobs {r['cobs_errors']:.0f}/s  "
+                      f"core0 decode {r['decode_load']:4.0%} convert {r['convert_load']:4.0%} "
+                      f"(max {r['convert_max_ms']:.2f} ms)  core1 idle {r['core1_idle']:4.0%}  ",
+                      end='', flush=True)
+                prev = cur
+        except KeyboardInterrupt:
+            print()
+
+    def _video_frames(self, path: Union[str, Path]) -> Tuple[Iterable[np.ndarray], float]:
+        """RGB frames of a video file, and its frame rate."""
+        if not HAS_CV2:
+            raise ImportError("OpenCV required: pip install opencv-python")
+
+        cap = cv2.VideoCapture(str(path))
+        if not cap.isOpened():
+            raise ValueError(f"Cannot open video: {path}")
+        fps = cap.get(cv2.CAP_PROP_FPS) or 30
+
+        def frames():
+            try:
+                while True:
+                    ret, frame = cap.read()
+                    if not ret:
+                        return
+                    yield cv2.cvtColor(frame, cv2.COLOR_BGR2RGB)
+            finally:
+                cap.release()
+
+        return frames(), fps
+
+    def upload_video_clip(
+        self, path: Union[str, Path], slot: int = 0, autoplay: bool = False
+    ) -> int:
+        """Store a video file as a clip at its own frame rate (see upload_clip)."""
+        frames, fps = self._video_frames(path)
+        return self.upload_clip(frames, slot, fps, autoplay)
+
+    def upload_demo_clip(
+        self,
+        demo_name: str,
+        slot: int = 0,
+        fps: float = 30.0,
+        seconds: float = 5.0,
+        autoplay: bool = False
+    ) -> int:
+        """Store `seconds` of a demo animation as a clip (see upload_clip)."""
+        demo = self._demo(demo_name)
+        count = max(1, int(seconds * fps))
+        frames = (demo(i / fps) for i in range(count))
+        return self.upload_clip(frames, slot, fps, autoplay)
+
     def fill(self, color: Tuple[int, int, int]):
         """Fill display with solid color."""
         image = np.full((self.height, self.width, 3), color, dtype=np.uint8)
@@ -279,9 +1122,15 @@ class LEDMatrixController:
         """
         Play a video file with frame dropping to maintain target frame rate.
 
-        The maximum frame rate is limited to MAX_VIDEO_FPS (15fps).
-        If the video's frame rate exceeds this limit, frames are dropped
-        to achieve approximately 15fps output.
+        Frames go through preallocated VideoBuffers (decode, letterbox,
+        pixel conversion and the encoded packet reuse their arrays).
+
+        With flow control the output runs as fast as the device accepts
+        frames (up to the video's rate); each send waits for a credit and
+        the frames that fall behind are dropped. Without it the output is
+        limited to MAX_VIDEO_FPS. Each frame carries its presentation time
+        (PRESENTATION_DELAY after its ideal time), so the device flips at
+        the video's own pace instead of whenever a frame arrives.
 
         Args:
             path: Path to video file
@@ -296,60 +1145,70 @@ class LEDMatrixController:
 
         video_fps = cap.get(cv2.CAP_PROP_FPS) or 30
 
-        # Limit to MAX_VIDEO_FPS (15fps)
-        effective_fps = min(video_fps, MAX_VIDEO_FPS)
+        # Device-paced with credits, otherwise limited to MAX_VIDEO_FPS
+        if self.flow_control:
+            effective_fps = video_fps
+        else:
+            effective_fps = min(video_fps, MAX_VIDEO_FPS)
         frame_interval = 1.0 / effective_fps
 
         print(f"Playing: {path}")
-        print(f"Video FPS: {video_fps:.1f}, Output FPS: {effective_fps:.1f}")
+        pacing = "device credits" if self.flow_control else "fixed"
+        print(f"Video FPS: {video_fps:.1f}, Output FPS: {effective_fps:.1f} ({pacing})")
         print("Press Ctrl+C to stop")
 
+        buffers = VideoBuffers(self.width, self.height, self.pixel_format)
+
         try:
-            playback_start = time.time()
-            frames_sent = 0
-            frames_dropped = 0
-            next_frame_time = playback_start
+            with self.streaming():
+                playback_start = time.time()
+                pts_origin = host_time_us() + int(PRESENTATION_DELAY * 1e6)
+                frames_sent = 0
+                frames_dropped = 0
+                next_frame_time = playback_start
 
-            while True:
-                # Calculate ideal frame number based on elapsed time (using original video FPS)
-                elapsed = time.time() - playback_start
-                ideal_frame = int(elapsed * video_fps)
-
-                # Get current frame position
-                current_frame = int(cap.get(cv2.CAP_PROP_POS_FRAMES))
-
-                # Skip frames if we're behind (frame dropping based on video's original FPS)
-                if ideal_frame > current_frame:
-                    frames_to_skip = ideal_frame - current_frame
-                    frames_dropped += frames_to_skip
-                    cap.set(cv2.CAP_PROP_POS_FRAMES, ideal_frame)
-
-                ret, frame = cap.read()
-                if not ret:
-                    if loop:
-                        cap.set(cv2.CAP_PROP_POS_FRAMES, 0)
-                        playback_start = time.time()
-                        next_frame_time = playback_start
-                        frames_sent = 0
-                        frames_dropped = 0
-                        continue
-                    else:
-                        break
-
-                frame = cv2.cvtColor(frame, cv2.COLOR_BGR2RGB)
-                self.send_frame(frame)
-                frames_sent += 1
-
-                # Print progress periodically
-                if self._frame_count == 0:
-                    drop_rate = (frames_dropped / (frames_sent + frames_dropped) * 100) if (frames_sent + frames_dropped) > 0 else 0
-                    print(f"\rSent: {frames_sent}, Dropped: {frames_dropped} ({drop_rate:.1f}%)  ", end='', flush=True)
+                while True:
+                    # Calculate ideal frame number based on elapsed time (using original video FPS)
+                    elapsed = time.time() - playback_start
+                    ideal_frame = int(elapsed * video_fps)
+
+                    # Get current frame position
+                    current_frame = int(cap.get(cv2.CAP_PROP_POS_FRAMES))
 
-                # Wait until next frame time to maintain target FPS
-                next_frame_time += frame_interval
-                sleep_time = next_frame_time - time.time()
-                if sleep_time > 0:
-                    time.sleep(sleep_time)
+                    # Skip frames if we're behind (frame dropping based on video's original FPS)
+                    if ideal_frame > current_frame:
+                        frames_to_skip = ideal_frame - current_frame
+                        frames_dropped += frames_to_skip
+                        cap.set(cv2.CAP_PROP_POS_FRAMES, ideal_frame)
+
+                    ret = buffers.read(cap)
+                    if not ret:
+                        if loop:
+                            cap.set(cv2.CAP_PROP_POS_FRAMES, 0)
+                            playback_start = time.time()
+                            pts_origin = host_time_us() + int(PRESENTATION_DELAY * 1e6)
+                            next_frame_time = playback_start
+                            frames_sent = 0
+                            frames_dropped = 0
+                            continue
+                        else:
+                            break
+
+                    pts = pts_origin + int(max(ideal_frame, current_frame) * 1e6 / video_fps)
+                    pixels = buffers.wire_pixels(buffers.decoded)
+                    self._send_pixels(pixels, pts, out=buffers.packet_buffer())
+                    frames_sent += 1
+
+                    # Print progress periodically
+                    if self._frame_count == 0:
+                        drop_rate = (frames_dropped / (frames_sent + frames_dropped) * 100) if (frames_sent + frames_dropped) > 0 else 0
+                        print(f"\rSent: {frames_sent}, Dropped: {frames_dropped} ({drop_rate:.1f}%)  ", end='', flush=True)
+
+                    # Wait until next frame time to maintain target FPS
+                    next_frame_time += frame_interval
+                    sleep_time = next_frame_time - time.time()
+                    if sleep_time > 0:
+                        time.sleep(sleep_time)
 
         finally:
             cap.release()
@@ -359,8 +1218,8 @@ class LEDMatrixController:
     # Demo Modes
     # ========================================
     
-    def run_demo(self, demo_name: str, fps: float = 30.0):
-        """Run a demo animation."""
+    def _demo(self, demo_name: str):
+        """Frame function of a demo: t (seconds) -> RGB image."""
         demos = {
             "rainbow": self._demo_rainbow,
             "gradient": self._demo_gradient,
@@ -372,29 +1231,35 @@ class LEDMatrixController:
         
         if demo_name not in demos:
             raise ValueError(f"Unknown demo: {demo_name}")
-        
+        return demos[demo_name]
+
+    def run_demo(self, demo_name: str, fps: float = 30.0):
+        """Run a demo animation."""
+        demo = self._demo(demo_name)
+
         print(f"Running demo: {demo_name}")
         print("Press Ctrl+C to stop")
         
         frame_time = 1.0 / fps
         
         try:
-            t = 0.0
-            while True:
-                start = time.time()
-                
-                image = demos[demo_name](t)
-                self.send_frame(image)
-                
-                t += frame_time
-                
-                elapsed = time.time() - start
-                if elapsed < frame_time:
-                    time.sleep(frame_time - elapsed)
-                
-                if self._frame_count == 0:
-                    print(f"\rFPS: {self.fps:.1f}  ", end='', flush=True)
-                    
+            with self.streaming():
+                t = 0.0
+                while True:
+                    start = time.time()
+
+                    image = demo(t)
+                    self.send_frame(image)
+
+                    t += frame_time
+
+                    elapsed = time.time() - start
+                    if elapsed < frame_time:
+                        time.sleep(frame_time - elapsed)
+
+                    if self._frame_count == 0:
+                        print(f"\rFPS: {self.fps:.1f}  ", end='', flush=True)
+
         except KeyboardInterrupt:
             print()
     
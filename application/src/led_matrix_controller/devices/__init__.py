@@ -6,11 +6,14 @@ Output device implementations.
 
 from .base import BaseDevice
 from .serial_device import SerialDevice
-from .simulator import TerminalDevice, ImageDevice
+from .usb_device import USBDevice
+from .simulator import TerminalDevice, ImageDevice, CaptureDevice
 
 __all__ = [
     "BaseDevice",
     "SerialDevice",
+    "USBDevice",
     "TerminalDevice",
     "ImageDevice",
+    "CaptureDevice",
 ]
@@ -38,6 +38,15 @@ class BaseDevice(ABC):
             True if successful
         """
         pass
+
+    def receive(self) -> bytes:
+        """
+        Read whatever the device has sent back, without blocking.
+
+        Returns:
+            Received bytes (b'' if none, or the device never replies)
+        """
+        return b''
     
     @property
     @abstractmethod
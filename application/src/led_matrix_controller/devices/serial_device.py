@@ -115,6 +115,19 @@ class SerialDevice(BaseDevice):
             print(f"Serial error: {e}")
             return False
     
+    def receive(self) -> bytes:
+        """Read the bytes the firmware has sent (credit reports)."""
+        if not self._serial:
+            return b''
+
+        try:
+            waiting = self._serial.in_waiting
+            return self._serial.read(waiting) if waiting else b''
+
+        except serial.SerialException as e:
+            print(f"Serial error: {e}")
+            return b''
+
     @property
     def is_connected(self) -> bool:
         """Check if connected."""
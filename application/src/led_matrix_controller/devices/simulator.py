@@ -4,13 +4,13 @@ Simulator Devices
 Terminal output and image file output for testing without hardware.
 """
 
-import base64
 from pathlib import Path
 from typing import Optional
 
 import numpy as np
 
 from .base import BaseDevice
+from ..protocol import cobs_decode, FrameState
 
 
 # Display configuration
@@ -18,6 +18,37 @@ DISPLAY_WIDTH = 128
 DISPLAY_HEIGHT = 32
 
 
+def decode_packets(frame: FrameState, data: bytes) -> bool:
+    """
+    Apply COBS packets (0x00-terminated) to a frame like the firmware.
+
+    Args:
+        frame: Device frame state, updated in place
+        data: One or more encoded packets (bytes or a buffer view)
+
+    Returns:
+        True if at least one packet was accepted
+    """
+    accepted = False
+    for chunk in bytes(data).split(b'\x00'):
+        if not chunk:
+            continue
+        packet = cobs_decode(chunk)
+        if packet is not None and frame.apply(packet):
+            accepted = True
+    return accepted
+
+
+def frame_to_rgb(frame: FrameState) -> tuple:
+    """Split a frame into 8-bit R, G, B planes in display order."""
+    # Undo the host-side horizontal flip for HUB75 shift order
+    rgb = np.fliplr(frame.to_rgb())
+    if frame.brightness < 255:
+        # Firmware dims by OE on-time; emulate the resulting light output
+        rgb = (rgb.astype(np.uint16) * frame.brightness // 255).astype(np.uint8)
+    return rgb[:, :, 0], rgb[:, :, 1], rgb[:, :, 2]
+
+
 class TerminalDevice(BaseDevice):
     """
     Terminal-based simulator.
@@ -34,6 +65,7 @@ class TerminalDevice(BaseDevice):
         self.use_color = use_color
         self._connected = False
         self._frame_count = 0
+        self._frame = FrameState(DISPLAY_WIDTH, DISPLAY_HEIGHT)
     
     def connect(self) -> bool:
         """Connect (no-op for terminal)."""
@@ -54,19 +86,12 @@ class TerminalDevice(BaseDevice):
             return False
         
         try:
-            # Decode Base64
-            b64_data = data.rstrip(b'\n')
-            raw_data = base64.b64decode(b64_data)
-            
-            # Convert to RGB565 array
-            rgb565 = np.frombuffer(raw_data, dtype='<u2').reshape(
-                DISPLAY_HEIGHT, DISPLAY_WIDTH
-            )
-            
+            # Decode COBS packets into the frame buffer
+            if not decode_packets(self._frame, data):
+                return False
+
             # Convert to RGB888
-            r = ((rgb565 >> 11) & 0x1F) << 3
-            g = ((rgb565 >> 5) & 0x3F) << 2
-            b = (rgb565 & 0x1F) << 3
+            r, g, b = frame_to_rgb(self._frame)
             
             # Clear screen and move cursor
             print("\033[H\033[J", end='')
@@ -109,6 +134,51 @@ class TerminalDevice(BaseDevice):
         return self._connected
 
 
+class CaptureDevice(BaseDevice):
+    """
+    Headless simulator: applies packets to a frame like the firmware and
+    counts the traffic, without rendering. Used by the benchmark.
+    """
+
+    def __init__(self, width: int = DISPLAY_WIDTH, height: int = DISPLAY_HEIGHT):
+        """
+        Initialize capture device.
+
+        Args:
+            width: Display width in pixels
+            height: Display height in pixels
+        """
+        self.frame = FrameState(width, height)
+        self.bytes_sent = 0
+        self.sends = 0
+        self.rejected = 0
+        self._connected = False
+
+    def connect(self) -> bool:
+        """Connect (no-op)."""
+        self._connected = True
+        return True
+
+    def disconnect(self):
+        """Disconnect (no-op)."""
+        self._connected = False
+
+    def send(self, data: bytes, wait_ack: bool = True) -> bool:
+        """Apply packets to the frame; False if none was accepted."""
+        if not self._connected:
+            return False
+        self.bytes_sent += len(data)
+        self.sends += 1
+        if not decode_packets(self.frame, data):
+            self.rejected += 1
+            return False
+        return True
+
+    @property
+    def is_connected(self) -> bool:
+        return self._connected
+
+
 class ImageDevice(BaseDevice):
     """
     Image file output device.
@@ -134,6 +204,7 @@ class ImageDevice(BaseDevice):
         self.led_style = led_style
         self._connected = False
         self._frame_count = 0
+        self._frame = FrameState(DISPLAY_WIDTH, DISPLAY_HEIGHT)
         
         try:
             import cv2
@@ -160,19 +231,12 @@ class ImageDevice(BaseDevice):
             return False
         
         try:
-            # Decode Base64
-            b64_data = data.rstrip(b'\n')
-            raw_data = base64.b64decode(b64_data)
-            
-            # Convert to RGB565 array
-            rgb565 = np.frombuffer(raw_data, dtype='<u2').reshape(
-                DISPLAY_HEIGHT, DISPLAY_WIDTH
-            )
-            
+            # Decode COBS packets into the frame buffer
+            if not decode_packets(self._frame, data):
+                return False
+
             # Convert to RGB888
-            r = ((rgb565 >> 11) & 0x1F) << 3
-            g = ((rgb565 >> 5) & 0x3F) << 2
-            b = (rgb565 & 0x1F) << 3
+            r, g, b = frame_to_rgb(self._frame)
             
             image = np.stack([r, g, b], axis=-1).astype(np.uint8)
             
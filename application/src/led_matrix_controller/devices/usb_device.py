@@ -0,0 +1,154 @@
+"""
+USB Vendor Device
+
+Communicates with RP2040 via the WebUSB vendor (bulk) interface.
+Requires firmware built with HUB75_USE_VENDOR=1 (env: pico_webusb).
+"""
+
+from typing import Optional
+
+try:
+    import usb.core
+    import usb.util
+    HAS_PYUSB = True
+except ImportError:
+    HAS_PYUSB = False
+
+from .base import BaseDevice
+
+# Raspberry Pi USB vendor ID (RP2040 default)
+RP2040_VID = 0x2E8A
+
+# Vendor-specific interface class
+USB_CLASS_VENDOR = 0xFF
+
+
+class USBDevice(BaseDevice):
+    """USB vendor-class bulk device for RP2040 (same packets as CDC)."""
+
+    def __init__(
+        self,
+        vid: int = RP2040_VID,
+        pid: Optional[int] = None,
+        timeout: float = 2.0
+    ):
+        """
+        Initialize USB vendor device.
+
+        Args:
+            vid: USB vendor ID
+            pid: USB product ID (first device with a vendor interface if None)
+            timeout: Write timeout in seconds
+        """
+        if not HAS_PYUSB:
+            raise ImportError("pyusb required: pip install pyusb")
+
+        self.vid = vid
+        self.pid = pid
+        self.timeout = timeout
+        self._dev = None
+        self._intf = None
+        self._ep_out = None
+        self._ep_in = None
+
+    def _find_vendor_interface(self, dev):
+        """Return the vendor-class interface of dev, or None."""
+        for intf in dev.get_active_configuration():
+            if intf.bInterfaceClass == USB_CLASS_VENDOR:
+                return intf
+        return None
+
+    def connect(self) -> bool:
+        """Connect to the first matching device exposing a vendor interface."""
+        kwargs = {"idVendor": self.vid}
+        if self.pid is not None:
+            kwargs["idProduct"] = self.pid
+
+        for dev in usb.core.find(find_all=True, **kwargs):
+            try:
+                if dev.get_active_configuration() is None:
+                    dev.set_configuration()
+            except usb.core.USBError:
+                dev.set_configuration()
+
+            intf = self._find_vendor_interface(dev)
+            if intf is None:
+                continue
+
+            ep_out = usb.util.find_descriptor(
+                intf,
+                custom_match=lambda e: (
+                    usb.util.endpoint_direction(e.bEndpointAddress)
+                    == usb.util.ENDPOINT_OUT
+                )
+            )
+            if ep_out is None:
+                continue
+            ep_in = usb.util.find_descriptor(
+                intf,
+                custom_match=lambda e: (
+                    usb.util.endpoint_direction(e.bEndpointAddress)
+                    == usb.util.ENDPOINT_IN
+                )
+            )
+
+            try:
+                usb.util.claim_interface(dev, intf)
+            except usb.core.USBError as e:
+                raise RuntimeError(f"Failed to claim USB interface: {e}")
+
+            self._dev = dev
+            self._intf = intf
+            self._ep_out = ep_out
+            self._ep_in = ep_in
+            print(f"Connected to USB {dev.idVendor:04x}:{dev.idProduct:04x}")
+            return True
+
+        raise RuntimeError(
+            "No USB vendor interface found. "
+            "Check USB connection and firmware (pico_webusb)"
+        )
+
+    def disconnect(self):
+        """Release the interface and the device."""
+        if self._dev is not None:
+            usb.util.release_interface(self._dev, self._intf)
+            usb.util.dispose_resources(self._dev)
+        self._dev = None
+        self._intf = None
+        self._ep_out = None
+        self._ep_in = None
+
+    def send(self, data: bytes, wait_ack: bool = True) -> bool:
+        """Send data to the device (wait_ack ignored, kept for compatibility)."""
+        if self._ep_out is None:
+            raise RuntimeError("Not connected")
+
+        try:
+            # One bulk transfer per packet; the stack splits it into 64-byte
+            # USB packets
+            self._ep_out.write(data, timeout=int(self.timeout * 1000))
+            return True
+
+        except usb.core.USBError as e:
+            print(f"USB error: {e}")
+            return False
+
+    def receive(self) -> bytes:
+        """Read the bytes the firmware has sent (credit reports)."""
+        if self._ep_in is None:
+            return b''
+
+        try:
+            return bytes(self._ep_in.read(self._ep_in.wMaxPacketSize, timeout=1))
+
+        except usb.core.USBTimeoutError:
+            return b''
+        except usb.core.USBError as e:
+            print(f"USB error: {e}")
+            return b''
+
+    @property
+    def is_connected(self) -> bool:
+        """Check if connected."""
+        return self._ep_out is not None
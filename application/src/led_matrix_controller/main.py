@@ -17,13 +17,27 @@ import sys
 from pathlib import Path
 
 from .controller import LEDMatrixController
-from .devices import SerialDevice, TerminalDevice, ImageDevice
+from .devices import SerialDevice, USBDevice, TerminalDevice, ImageDevice
+from .wall import VideoWall
+
+
+def parse_size(text: str, what: str) -> tuple:
+    """'AxB' -> (A, B) positive ints."""
+    try:
+        a, b = (int(v) for v in text.lower().split("x"))
+    except ValueError:
+        raise ValueError(f"{what} must look like 2x1, got {text!r}")
+    if a <= 0 or b <= 0:
+        raise ValueError(f"{what} must be positive, got {text!r}")
+    return a, b
 
 
 def create_device(args):
     """Create appropriate device based on arguments."""
     if args.device == "serial":
         return SerialDevice(port=args.port, baudrate=args.baudrate)
+    elif args.device == "usb":
+        return USBDevice()
     elif args.device == "terminal":
         return TerminalDevice()
     elif args.device == "image":
@@ -32,6 +46,32 @@ def create_device(args):
         raise ValueError(f"Unknown device type: {args.device}")
 
 
+def create_wall(args, cols: int, rows: int) -> VideoWall:
+    """Create a video wall: one serial port (or image directory) per tile."""
+    count = cols * rows
+    if args.device == "serial":
+        ports = args.port.split(",") if args.port else []
+        if len(ports) != count:
+            raise ValueError(f"--wall {cols}x{rows} needs {count} ports in --port (comma-separated)")
+        devices = [SerialDevice(port=port, baudrate=args.baudrate) for port in ports]
+    elif args.device == "image":
+        devices = [ImageDevice(output_dir=str(Path(args.output_dir) / f"tile{i}"))
+                   for i in range(count)]
+    else:
+        raise ValueError("--wall supports the serial and image devices")
+
+    tile_w, tile_h = parse_size(args.tile_size, "--tile-size")
+    return VideoWall(
+        devices, cols, rows,
+        tile_width=tile_w,
+        tile_height=tile_h,
+        brightness=args.brightness,
+        pixel_format=args.format,
+        compress=not args.no_compress,
+        sync=not args.no_sync
+    )
+
+
 def main():
     parser = argparse.ArgumentParser(
         description="LED Matrix Controller for 128x32 HUB75 panel",
@@ -47,6 +87,25 @@ Examples:
   # Rainbow demo
   python -m led_matrix_controller.main --demo rainbow
 
+  # Scrolling text drawn by the firmware (a few bytes per frame)
+  python -m led_matrix_controller.main --ticker "HELLO WORLD"
+
+  # WebUSB vendor interface (firmware env: pico_webusb)
+  python -m led_matrix_controller.main --device usb --demo rainbow
+
+  # Store a demo in flash slot 1, loop it at boot (firmware env: pico_clips)
+  python -m led_matrix_controller.main --demo plasma --upload-clip 1 --autoplay
+
+  # Play flash slot 1 (keeps running after the host exits)
+  python -m led_matrix_controller.main --play-clip 1
+
+  # Live performance counters of a running panel (refresh, load, errors)
+  python -m led_matrix_controller.main --stats
+
+  # 2x2 wall of four panels (ports row by row from the top left)
+  python -m led_matrix_controller.main --wall 2x2 \
+      --port /dev/ttyACM0,/dev/ttyACM1,/dev/ttyACM2,/dev/ttyACM3 --video movie.mp4
+
   # Terminal preview (no hardware)
   python -m led_matrix_controller.main --device terminal --demo rainbow
 """
@@ -56,14 +115,14 @@ Examples:
     device_group = parser.add_argument_group("Device options")
     device_group.add_argument(
         "--device", "-d",
-        choices=["serial", "terminal", "image"],
+        choices=["serial", "usb", "terminal", "image"],
         default="serial",
         help="Output device type (default: serial)"
     )
     device_group.add_argument(
         "--port", "-p",
         default=None,
-        help="Serial port (auto-detect if not specified)"
+        help="Serial port (auto-detect if not specified; one per tile with --wall)"
     )
     device_group.add_argument(
         "--baudrate", "-b",
@@ -77,6 +136,25 @@ Examples:
         help="Output directory for image device (default: output)"
     )
     
+    # Video wall options
+    wall_group = parser.add_argument_group("Video wall options")
+    wall_group.add_argument(
+        "--wall",
+        metavar="COLSxROWS",
+        help="Drive a grid of devices as one display (e.g. 2x2)"
+    )
+    wall_group.add_argument(
+        "--tile-size",
+        metavar="WxH",
+        default="128x32",
+        help="Display size of each wall device (default: 128x32)"
+    )
+    wall_group.add_argument(
+        "--no-sync",
+        action="store_true",
+        help="Let each wall tile flip as soon as its frame is converted"
+    )
+
     # Input options (mutually exclusive)
     input_group = parser.add_argument_group("Input options")
     input_mutex = input_group.add_mutually_exclusive_group()
@@ -95,11 +173,56 @@ Examples:
         choices=["rainbow", "gradient", "plasma", "fire", "matrix", "clock"],
         help="Run demo animation"
     )
+    input_mutex.add_argument(
+        "--ticker",
+        metavar="TEXT",
+        help="Scroll a line of text with firmware drawing commands"
+    )
     input_mutex.add_argument(
         "--fill", "-f",
         metavar="R,G,B",
         help="Fill with solid color (e.g., 255,0,0 for red)"
     )
+    input_mutex.add_argument(
+        "--play-clip",
+        type=int,
+        metavar="SLOT",
+        help="Loop a clip stored in the device's flash"
+    )
+    input_mutex.add_argument(
+        "--stats",
+        action="store_true",
+        help="Monitor the device's performance counters (display left as is)"
+    )
+
+    # Flash clip options
+    clip_group = parser.add_argument_group("Flash clip options")
+    clip_group.add_argument(
+        "--upload-clip",
+        type=int,
+        metavar="SLOT",
+        help="Store --video or --demo in a flash slot and play it, instead of streaming"
+    )
+    clip_group.add_argument(
+        "--autoplay",
+        action="store_true",
+        help="Play the uploaded clip whenever the device boots"
+    )
+    clip_group.add_argument(
+        "--clip-seconds",
+        type=float,
+        default=5.0,
+        help="Length of an uploaded demo clip (default: 5)"
+    )
+
+    # Monitoring options
+    stats_group = parser.add_argument_group("Monitoring options")
+    stats_group.add_argument(
+        "--stats-interval",
+        type=float,
+        default=1.0,
+        help="Seconds between --stats readings (default: 1)"
+    )
     
     # Display options
     display_group = parser.add_argument_group("Display options")
@@ -120,31 +243,116 @@ Examples:
         default=1.0,
         help="Brightness multiplier 0.0-1.0 (default: 1.0)"
     )
+    display_group.add_argument(
+        "--format",
+        choices=["rgb565", "rgb332"],
+        default="rgb565",
+        help="Wire pixel format (rgb332 halves USB traffic, default: rgb565)"
+    )
+    display_group.add_argument(
+        "--no-compress",
+        action="store_true",
+        help="Send pixels uncompressed (firmware without run-length decoding)"
+    )
+    display_group.add_argument(
+        "--pipeline",
+        action="store_true",
+        help="Encode video/demo frames on a background thread while sending"
+    )
+    display_group.add_argument(
+        "--gamma",
+        type=float,
+        default=None,
+        help="Upload a gamma curve to the firmware (boot default: 2.2)"
+    )
+    display_group.add_argument(
+        "--white-balance",
+        metavar="R,G,B",
+        default=None,
+        help="Per-channel gain 0.0-1.0 for the uploaded curve (e.g. 1,0.9,0.8)"
+    )
+    display_group.add_argument(
+        "--depth",
+        type=int,
+        choices=[4, 6, 8, 10],
+        default=None,
+        help="Colour depth in bits per channel (default: firmware setting)"
+    )
 
     
     args = parser.parse_args()
     
     # Validate arguments
-    if not any([args.image, args.video, args.demo, args.fill]):
+    if not any([args.image, args.video, args.demo, args.ticker, args.fill,
+                args.play_clip is not None, args.stats]):
         parser.print_help()
-        print("\nError: Please specify an input source (--image, --video, --demo, or --fill)")
+        print("\nError: Please specify an input source "
+              "(--image, --video, --demo, --ticker, --fill, --play-clip or --stats)")
+        sys.exit(1)
+    if args.upload_clip is not None and not (args.video or args.demo):
+        parser.print_help()
+        print("\nError: --upload-clip needs --video or --demo")
+        sys.exit(1)
+    if args.wall and (args.stats or args.ticker or args.play_clip is not None or
+                      args.upload_clip is not None):
+        parser.print_help()
+        print("\nError: clips, --ticker and --stats address one device, not a --wall")
         sys.exit(1)
     
     try:
-        # Create device
-        device = create_device(args)
-
-        # Create controller (now uses COBS encoding)
-        controller = LEDMatrixController(
-            device=device,
-            brightness=args.brightness
-        )
+        if args.wall:
+            # One controller per tile behind a single wall-sized display
+            controller = create_wall(args, *parse_size(args.wall, "--wall"))
+        else:
+            # Create device
+            device = create_device(args)
+
+            # Create controller (now uses COBS encoding)
+            controller = LEDMatrixController(
+                device=device,
+                brightness=args.brightness,
+                pixel_format=args.format,
+                compress=not args.no_compress,
+                pipeline=args.pipeline
+            )
         
-        # Connect
+        # Connect (monitoring leaves the panel's settings alone)
+        if args.stats:
+            controller.connect(configure=False)
+            try:
+                controller.monitor_stats(args.stats_interval)
+            finally:
+                controller.disconnect()
+            return
+
         controller.connect()
+        if args.depth is not None:
+            controller.set_depth(args.depth)
+        if args.gamma is not None or args.white_balance:
+            gains = (1.0, 1.0, 1.0)
+            if args.white_balance:
+                gains = tuple(map(float, args.white_balance.split(",")))
+            controller.set_gamma(args.gamma if args.gamma is not None else 2.2, gains)
         
+        # Clips keep playing on the device after the host exits
+        clip_slot = args.upload_clip if args.upload_clip is not None else args.play_clip
+
         try:
-            if args.image:
+            if clip_slot is not None:
+                if args.upload_clip is not None:
+                    if args.video:
+                        count = controller.upload_video_clip(
+                            args.video, clip_slot, autoplay=args.autoplay)
+                    else:
+                        count = controller.upload_demo_clip(
+                            args.demo, clip_slot, fps=args.fps,
+                            seconds=args.clip_seconds, autoplay=args.autoplay)
+                    if count == 0:
+                        raise RuntimeError("Clip upload failed")
+                    print(f"Stored {count} frames in slot {clip_slot}")
+                controller.play_clip(clip_slot)
+
+            elif args.image:
                 controller.display_image(args.image)
                 input("Press Enter to exit...")
 
@@ -154,6 +362,9 @@ Examples:
             elif args.demo:
                 controller.run_demo(args.demo, fps=args.fps)
 
+            elif args.ticker:
+                controller.run_ticker(args.ticker, fps=args.fps)
+
             elif args.fill:
                 r, g, b = map(int, args.fill.split(","))
                 controller.fill((r, g, b))
@@ -162,7 +373,8 @@ Examples:
         except KeyboardInterrupt:
             print("\nStopped")
         finally:
-            controller.clear()
+            if clip_slot is None:
+                controller.clear()
             controller.disconnect()
             
     except Exception as e:
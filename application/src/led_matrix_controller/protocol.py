@@ -0,0 +1,1252 @@
+"""
+Host Protocol
+
+Packet framing shared with the RP2040 firmware
+(see firmware/include/hub75_protocol.h).
+
+Every packet is COBS-encoded and terminated by 0x00. A decoded packet is
+either a legacy raw RGB565 frame (exactly width * height * 2 bytes) or a
+versioned packet: 4-byte header followed by a type-specific body.
+
+Frame packets carry their pixel format in the header flags. Pixel arrays
+passed to the builders are (H, W): uint16 for RGB565, uint8 otherwise
+(P4 holds indices 0-15, packed two per byte on the wire).
+"""
+
+import struct
+import time
+from typing import Iterable, List, Optional
+
+import numpy as np
+
+from .font import text_mask
+
+
+PROTO_MAGIC = 0xA5
+PROTO_VERSION = 1
+
+# Packet types
+PKT_FRAME_FULL = 0x01   # Body: full RGB565 frame
+PKT_FRAME_ROWS = 0x02   # Body: y, height (u16) + rows of pixels
+PKT_FRAME_RECT = 0x03   # Body: x, y, width, height (u16) + pixels
+PKT_PALETTE = 0x04      # Body: first, count (u16) + count RGB888 entries
+PKT_DEPTH = 0x05        # Body: depth (u8), bits per channel
+PKT_BRIGHTNESS = 0x06   # Body: level (u8), OE on-time scale out of 255
+PKT_LUT = 0x07          # Body: channel (u8) + u16 levels (32/64/32 entries)
+PKT_CREDIT = 0x08       # Body: frames (u16), window (u8); also sent by the device
+PKT_CLOCK = 0x09        # Body: host time (u32, microseconds)
+PKT_CLIP_DATA = 0x0A    # Body: clip (u8), reserved (u8), page (u16) + 256 stream bytes
+PKT_CLIP_SAVE = 0x0B    # Body: clip, flags (u8), interval_ms (u16), length (u32)
+PKT_CLIP_PLAY = 0x0C    # Body: clip (u8), CLIP_STOP to stop
+PKT_STATS = 0x0D        # Body: none (query); device reply: counters (see parse_stats)
+PKT_DRAW_FILL = 0x0E    # Body: x, y, width, height, color (u16)
+PKT_SPRITE = 0x0F       # Body: slot, reserved (u8), width, height (u16) + pixels
+PKT_DRAW_BLIT = 0x10    # Body: slot, flags (u8), x, y (i16), key (u16)
+PKT_DRAW_SCROLL = 0x11  # Body: x, y, width, height (u16), dx, dy (i16)
+PKT_DRAW_TEXT = 0x12    # Body: x, y (i16), color, background (u16), flags, length (u8) + text
+
+DRAW_PACKETS = (PKT_DRAW_FILL, PKT_DRAW_BLIT, PKT_DRAW_SCROLL, PKT_DRAW_TEXT)
+FRAME_PACKETS = (PKT_FRAME_FULL, PKT_FRAME_ROWS, PKT_FRAME_RECT)
+
+# Pixel formats (header flags & PKT_FORMAT_MASK)
+PKT_FORMAT_MASK = 0x07
+PIXFMT_RGB565 = 0       # 16 bpp
+PIXFMT_RGB332 = 1       # 8 bpp, RRRGGGBB
+PIXFMT_P8 = 2           # 8 bpp palette index
+PIXFMT_P4 = 3           # 4 bpp palette index, low nibble first
+
+# Frame and drawing packets only: presentation time (u32 host microseconds)
+# after the header
+PKT_FLAG_PTS = 0x08
+# Frame and sprite packets only: run-length coded pixel data (see rle_encode)
+PKT_FLAG_RLE = 0x10
+
+# Drawing packet flags
+BLIT_FLAG_KEY = 0x01            # Skip sprite pixels equal to the key colour
+TEXT_FLAG_BACKGROUND = 0x01     # Fill the character cells with the background
+
+# Sprite cache (firmware defaults SPRITE_SLOTS / SPRITE_BYTES)
+SPRITE_SLOTS = 8
+SPRITE_BYTES = 2048
+
+# Flash clips (firmware built with HUB75_USE_CLIPS)
+CLIP_PAGE_SIZE = 256
+CLIP_STOP = 0xFF
+CLIP_FLAG_AUTOPLAY = 0x01
+
+PIXFMT_BITS = {
+    PIXFMT_RGB565: 16,
+    PIXFMT_RGB332: 8,
+    PIXFMT_P8: 8,
+    PIXFMT_P4: 4,
+}
+
+# RGB565 channel curve sizes (PKT_LUT): R, G, B
+LUT_ENTRIES = (32, 64, 32)
+
+# Runtime BCM depths (up to the firmware's COLOR_DEPTH)
+COLOR_DEPTHS = (4, 6, 8, 10)
+
+HEADER_SIZE = 4
+
+# PKT_STATS reply body (pkt_stats_t): twelve u32 counters, clk_mhz (u16),
+# depth and queued (u8)
+STATS_FIELDS = (
+    'time_us', 'rx_bytes', 'packets', 'dropped', 'cobs_errors', 'frames',
+    'flips', 'sweeps', 'decode_cycles', 'convert_cycles', 'convert_max_cycles',
+    'idle_cycles', 'clk_mhz', 'depth', 'queued',
+)
+STATS_STRUCT = struct.Struct('<12IHBB')
+
+# Frame packet header with a presentation time (largest frame header)
+FRAME_HEADER_MAX = 8
+
+# Packets at least this long are COBS-encoded with array operations
+COBS_VECTOR_MIN = 64
+
+
+def _cobs_encode_loop(data: bytes) -> bytes:
+    """Byte-at-a-time COBS encoder for short packets (see cobs_encode)."""
+    output = bytearray()
+    code_index = 0
+    code = 1
+
+    output.append(0)  # Placeholder for first code
+
+    for byte in data:
+        if byte == 0:
+            # Found zero - write code and start new segment
+            output[code_index] = code
+            code_index = len(output)
+            output.append(0)  # Placeholder for next code
+            code = 1
+        else:
+            # Copy non-zero byte
+            output.append(byte)
+            code += 1
+
+            if code == 0xFF:
+                # Segment full (254 bytes) - write code and start new segment
+                output[code_index] = code
+                code_index = len(output)
+                output.append(0)  # Placeholder for next code
+                code = 1
+
+    # Write final code
+    output[code_index] = code
+
+    return bytes(output)
+
+
+def cobs_max_size(length: int) -> int:
+    """Largest COBS encoding of `length` bytes (without the 0x00 terminator)."""
+    return length + length // 254 + 1
+
+
+def cobs_encode(data: bytes) -> bytes:
+    """
+    Encode data using COBS (Consistent Overhead Byte Stuffing).
+
+    COBS removes all zero bytes from the data stream, replacing them
+    with overhead codes. The packet is terminated with a zero byte.
+
+    Args:
+        data: Input data to encode
+
+    Returns:
+        COBS-encoded data (does not include terminating 0x00)
+    """
+    if not data:
+        return b'\x01'  # Empty packet
+    if len(data) < COBS_VECTOR_MIN:
+        return _cobs_encode_loop(data)
+
+    out = np.empty(cobs_max_size(len(data)), dtype=np.uint8)
+    return out[:cobs_encode_into(data, out)].tobytes()
+
+
+def cobs_encode_into(data: bytes, out: np.ndarray) -> int:
+    """
+    COBS-encode data into a preallocated buffer (output as cobs_encode).
+
+    Packets of COBS_VECTOR_MIN bytes or more (frames) are encoded with
+    array operations instead of a Python loop. The zeros split the data
+    into runs and each run becomes run // 254 + 1 blocks. The data is
+    copied in slices that end where a full block forces an extra code
+    (at most one per 254 bytes); within a slice each zero is exactly
+    where the next block's code goes, so the codes are then written over
+    them in one indexed store. This keeps the code 0x01 block that
+    follows a full 254-byte block, like the byte loop.
+
+    Args:
+        data: Input data to encode
+        out: uint8 array of at least cobs_max_size(len(data)) bytes
+
+    Returns:
+        Encoded length (out[:length] is the packet, without 0x00)
+    """
+    if len(data) < COBS_VECTOR_MIN:
+        encoded = cobs_encode(data)
+        out[:len(encoded)] = np.frombuffer(encoded, dtype=np.uint8)
+        return len(encoded)
+
+    raw = np.frombuffer(data, dtype=np.uint8)
+    zeros = np.flatnonzero(raw == 0)
+
+    # Non-zero runs between zeros (and the data's ends)
+    starts = np.concatenate(([0], zeros + 1))
+    runs = np.append(zeros, len(raw)) - starts
+
+    # Blocks of up to 254 bytes per run; a run ends with a short block
+    blocks = runs // 254 + 1
+    block_index = np.arange(int(blocks.sum())) - np.repeat(np.cumsum(blocks) - blocks, blocks)
+    block_lens = np.minimum(np.repeat(runs, blocks) - 254 * block_index, 254)
+
+    # Blocks after the first of their run start with an inserted code
+    split = block_index > 0
+    inserts = (np.repeat(starts, blocks) + 254 * block_index)[split].tolist()
+    bounds = [0] + inserts + [len(raw)]
+    for shift in range(len(bounds) - 1):
+        lo, hi = bounds[shift], bounds[shift + 1]
+        out[lo + shift + 1:hi + shift + 1] = raw[lo:hi]
+
+    # Each code goes in front of its block's first data byte
+    code_pos = np.cumsum(block_lens + 1) - (block_lens + 1)
+    out[code_pos] = block_lens + 1
+    return len(raw) + 1 + len(inserts)
+
+
+def cobs_decode(data: bytes) -> Optional[bytes]:
+    """
+    Decode a COBS packet (without the terminating 0x00).
+
+    Returns:
+        Decoded bytes, or None if the packet is malformed
+    """
+    output = bytearray()
+    i = 0
+    n = len(data)
+
+    while i < n:
+        code = data[i]
+        if code == 0:
+            return None
+        i += 1
+        end = i + code - 1
+        if end > n:
+            return None
+        output += data[i:end]
+        i = end
+        if code != 0xFF and i < n:
+            output.append(0)
+
+    return bytes(output)
+
+
+def _finish(packet: bytes, frame_size: int) -> bytes:
+    """Pad a versioned packet that would be mistaken for a raw frame."""
+    if len(packet) == frame_size:
+        packet += b'\x00'
+    return packet
+
+
+def _header(packet_type: int, flags: int = 0) -> bytes:
+    return bytes((PROTO_MAGIC, PROTO_VERSION, packet_type, flags))
+
+
+def _frame_header(packet_type: int, flags: int, pts: Optional[int]) -> bytes:
+    """Frame packet header, followed by the presentation time if given."""
+    if pts is None:
+        return _header(packet_type, flags)
+    return _header(packet_type, flags | PKT_FLAG_PTS) + struct.pack('<I', pts & 0xFFFFFFFF)
+
+
+def rle_encode(data: bytes, unit: int) -> bytes:
+    """
+    Run-length code pixel data for PKT_FLAG_RLE.
+
+    Each run is a control byte c followed by c + 1 literal units (c < 0x80)
+    or by one unit repeated c - 0x7E times (c >= 0x80, 2-129 repeats).
+
+    Args:
+        data: Serialized pixels (see _pixel_bytes)
+        unit: Bytes per unit: 2 for RGB565, 1 for the 8/4-bit formats
+
+    Returns:
+        Coded bytes
+    """
+    units = np.frombuffer(data, dtype='<u2' if unit == 2 else np.uint8)
+    count = units.size
+    if count == 0:
+        return b''
+    starts = np.flatnonzero(np.concatenate(([True], units[1:] != units[:-1])))
+    lengths = np.diff(np.append(starts, count))
+
+    out = bytearray()
+
+    def literal(begin: int, end: int):
+        for first in range(begin, end, 128):
+            last = min(first + 128, end)
+            out.append(last - first - 1)
+            out.extend(data[first * unit:last * unit])
+
+    pending = None  # Start of the literal span being collected
+    for start, length in zip(starts.tolist(), lengths.tolist()):
+        if length == 1:
+            if pending is None:
+                pending = start
+            continue
+        if pending is not None:
+            literal(pending, start)
+            pending = None
+        while length >= 2:
+            repeat = min(length, 129)
+            out.append(0x7E + repeat)
+            out.extend(data[start * unit:(start + 1) * unit])
+            start += repeat
+            length -= repeat
+        if length == 1:
+            pending = start
+    if pending is not None:
+        literal(pending, count)
+    return bytes(out)
+
+
+def rle_decode(data: bytes, unit: int, size: int) -> Optional[bytes]:
+    """
+    Inverse of rle_encode for a block of size bytes.
+
+    Returns:
+        Decoded bytes, or None if the runs do not fill exactly size bytes
+        (one trailing pad byte is allowed, as on the firmware)
+    """
+    out = bytearray()
+    pos = 0
+    while len(out) < size and pos < len(data):
+        c = data[pos]
+        pos += 1
+        if c < 0x80:
+            n = (c + 1) * unit
+            out += data[pos:pos + n]
+            pos += n
+        else:
+            out += data[pos:pos + unit] * (c - 0x7E)
+            pos += unit
+    if len(out) != size or pos > len(data) or len(data) - pos > 1:
+        return None
+    return bytes(out)
+
+
+def _pixel_payload(block: np.ndarray, fmt: int, compress: bool) -> tuple:
+    """Header flags and pixel bytes of a block, run-length coded if smaller."""
+    data = _pixel_bytes(block, fmt)
+    if compress:
+        packed = rle_encode(data, 2 if fmt == PIXFMT_RGB565 else 1)
+        if len(packed) < len(data):
+            return fmt | PKT_FLAG_RLE, packed
+    return fmt, data
+
+
+def _pixel_bytes(pixels: np.ndarray, fmt: int) -> bytes:
+    """Serialize an (h, w) block of pixels in the given format."""
+    if fmt == PIXFMT_RGB565:
+        return pixels.astype('<u2').tobytes()
+    data = pixels.astype(np.uint8)
+    if fmt == PIXFMT_P4:
+        data = (data[:, 0::2] & 0x0F) | ((data[:, 1::2] & 0x0F) << 4)
+    return data.tobytes()
+
+
+def _unpack_pixels(data: bytes, width: int, height: int, fmt: int) -> np.ndarray:
+    """Inverse of _pixel_bytes: (height, width) array."""
+    if fmt == PIXFMT_RGB565:
+        return np.frombuffer(data, dtype='<u2').reshape(height, width)
+    raw = np.frombuffer(data, dtype=np.uint8)
+    if fmt == PIXFMT_P4:
+        raw = raw.reshape(height, width // 2)
+        out = np.empty((height, width), dtype=np.uint8)
+        out[:, 0::2] = raw & 0x0F
+        out[:, 1::2] = raw >> 4
+        return out
+    return raw.reshape(height, width)
+
+
+def build_full_frame(
+    pixels: np.ndarray,
+    fmt: int = PIXFMT_RGB565,
+    pts: Optional[int] = None,
+    compress: bool = False
+) -> bytes:
+    """
+    Full frame packet from an (H, W) pixel array, shown at host time pts.
+    With compress the pixels are run-length coded when that is smaller.
+    """
+    frame_size = pixels.size * 2
+    flags, data = _pixel_payload(pixels, fmt, compress)
+    return _finish(_frame_header(PKT_FRAME_FULL, flags, pts) + data, frame_size)
+
+
+def build_rows(
+    pixels: np.ndarray,
+    y: int,
+    height: int,
+    fmt: int = PIXFMT_RGB565,
+    pts: Optional[int] = None,
+    compress: bool = False
+) -> bytes:
+    """Row range packet for rows [y, y + height)."""
+    frame_size = pixels.size * 2
+    flags, data = _pixel_payload(pixels[y:y + height], fmt, compress)
+    body = struct.pack('<HH', y, height) + data
+    return _finish(_frame_header(PKT_FRAME_ROWS, flags, pts) + body, frame_size)
+
+
+def build_rect(
+    pixels: np.ndarray,
+    x: int,
+    y: int,
+    width: int,
+    height: int,
+    fmt: int = PIXFMT_RGB565,
+    pts: Optional[int] = None,
+    compress: bool = False
+) -> bytes:
+    """Rectangle packet for pixels [x, x + width) x [y, y + height)."""
+    frame_size = pixels.size * 2
+    flags, data = _pixel_payload(pixels[y:y + height, x:x + width], fmt, compress)
+    body = struct.pack('<HHHH', x, y, width, height) + data
+    return _finish(_frame_header(PKT_FRAME_RECT, flags, pts) + body, frame_size)
+
+
+def build_palette(colors: np.ndarray, first: int = 0, frame_size: int = 0) -> bytes:
+    """
+    Palette packet setting entries [first, first + len(colors)).
+
+    Args:
+        colors: (N, 3) uint8 RGB888 entries
+        first: First palette index to set
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    colors = np.asarray(colors, dtype=np.uint8).reshape(-1, 3)
+    body = struct.pack('<HH', first, len(colors)) + colors.tobytes()
+    return _finish(_header(PKT_PALETTE) + body, frame_size)
+
+
+def build_depth(depth: int, frame_size: int = 0) -> bytes:
+    """
+    Colour depth packet: fewer bits per channel refresh faster.
+
+    Args:
+        depth: Bits per channel, one of COLOR_DEPTHS
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    if depth not in COLOR_DEPTHS:
+        raise ValueError(f"Depth must be one of {COLOR_DEPTHS}")
+    return _finish(_header(PKT_DEPTH) + struct.pack('<B', depth), frame_size)
+
+
+def build_lut(channel: int, levels: np.ndarray, frame_size: int = 0) -> bytes:
+    """
+    Channel curve packet for RGB565 frames.
+
+    Args:
+        channel: 0 = R, 1 = G, 2 = B
+        levels: LUT_ENTRIES[channel] linear levels, 0-65535
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    levels = np.asarray(levels, dtype='<u2').ravel()
+    if channel not in (0, 1, 2) or len(levels) != LUT_ENTRIES[channel]:
+        raise ValueError(f"Channel {channel} needs {LUT_ENTRIES[channel % 3]} levels")
+    body = struct.pack('<B', channel) + levels.tobytes()
+    return _finish(_header(PKT_LUT) + body, frame_size)
+
+
+def gamma_lut(channel: int, gamma: float = 2.2, gain: float = 1.0) -> np.ndarray:
+    """
+    Power-law curve for one channel, matching the firmware's boot curve at
+    gamma 2.2 and gain 1.0.
+
+    Args:
+        channel: 0 = R, 1 = G, 2 = B
+        gamma: Curve exponent
+        gain: Output scale 0.0-1.0 (white balance)
+
+    Returns:
+        uint16 levels for build_lut()
+    """
+    entries = LUT_ENTRIES[channel]
+    shift = 2 if entries == 64 else 3
+    norm = (np.arange(entries) << shift) / 255.0
+    levels = np.power(norm, gamma) * 65535.0 * max(0.0, min(1.0, gain)) + 0.5
+    return levels.astype(np.uint16)
+
+
+def build_brightness(level: int, frame_size: int = 0) -> bytes:
+    """
+    Global brightness packet: the firmware scales OE on-times, so dimming
+    keeps the full colour depth.
+
+    Args:
+        level: 0 (off) to 255 (full)
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    if not 0 <= level <= 255:
+        raise ValueError("Brightness level must be 0-255")
+    return _finish(_header(PKT_BRIGHTNESS) + struct.pack('<B', level), frame_size)
+
+
+def build_credit(frames: int = 0, frame_size: int = 0) -> bytes:
+    """
+    Flow control packet: sets the device's count of consumed frame packets.
+    The device answers with its own PKT_CREDIT, so this doubles as a probe.
+
+    Args:
+        frames: New count (0 on connect)
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    return _finish(_header(PKT_CREDIT) + struct.pack('<HB', frames & 0xFFFF, 0), frame_size)
+
+
+def build_clock(time_us: int, frame_size: int = 0) -> bytes:
+    """
+    Clock packet: the host time that presentation timestamps refer to.
+
+    Args:
+        time_us: Host clock in microseconds (wraps at 32 bits)
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    return _finish(_header(PKT_CLOCK) + struct.pack('<I', time_us & 0xFFFFFFFF), frame_size)
+
+
+def build_clip_pages(clip: int, stream: bytes, frame_size: int = 0) -> List[bytes]:
+    """
+    PKT_CLIP_DATA packets writing a clip stream, in the order to send them.
+
+    Args:
+        clip: Flash slot
+        stream: Clip stream (see encode_clip), zero-padded to whole pages
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded), one per page
+    """
+    packets = []
+    for page, offset in enumerate(range(0, len(stream), CLIP_PAGE_SIZE)):
+        data = stream[offset:offset + CLIP_PAGE_SIZE].ljust(CLIP_PAGE_SIZE, b'\x00')
+        body = struct.pack('<BBH', clip, 0, page) + data
+        packets.append(_finish(_header(PKT_CLIP_DATA) + body, frame_size))
+    return packets
+
+
+def build_clip_save(
+    clip: int,
+    length: int,
+    interval_ms: int,
+    autoplay: bool = False,
+    frame_size: int = 0
+) -> bytes:
+    """
+    Finish a clip upload.
+
+    Args:
+        clip: Flash slot the pages were written to
+        length: Stream length in bytes
+        interval_ms: Time per frame on playback (1-65535)
+        autoplay: Play this clip when the device boots
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    if not 1 <= interval_ms <= 0xFFFF:
+        raise ValueError("Clip frame interval must be 1-65535 ms")
+    flags = CLIP_FLAG_AUTOPLAY if autoplay else 0
+    body = struct.pack('<BBHI', clip, flags, interval_ms, length)
+    return _finish(_header(PKT_CLIP_SAVE) + body, frame_size)
+
+
+def build_clip_play(clip: int, frame_size: int = 0) -> bytes:
+    """Start looping a saved clip (CLIP_STOP stops playback)."""
+    return _finish(_header(PKT_CLIP_PLAY) + struct.pack('<B', clip), frame_size)
+
+
+def build_stats_query(frame_size: int = 0) -> bytes:
+    """Ask the device for its performance counters (answered with PKT_STATS)."""
+    return _finish(_header(PKT_STATS), frame_size)
+
+
+def build_fill(
+    x: int, y: int, width: int, height: int, color: int,
+    fmt: int = PIXFMT_RGB565, pts: Optional[int] = None, frame_size: int = 0
+) -> bytes:
+    """
+    Solid rectangle drawn by the firmware, in display coordinates.
+
+    Args:
+        x, y, width, height: Rectangle inside the display (x from the left
+                             as seen, not mirrored like build_rect)
+        color: Pixel value in fmt, which must be the device's current
+               format unless the rectangle covers the whole display
+        fmt: Pixel format (PIXFMT_*)
+        pts: Presentation time in host microseconds, or None
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    body = struct.pack('<HHHHH', x, y, width, height, color)
+    return _finish(_frame_header(PKT_DRAW_FILL, fmt, pts) + body, frame_size)
+
+
+def build_sprite(
+    slot: int, pixels: np.ndarray, fmt: int = PIXFMT_RGB565,
+    compress: bool = False, frame_size: int = 0
+) -> bytes:
+    """
+    Store a sprite in one of the firmware's SPRITE_SLOTS for build_blit.
+
+    Args:
+        slot: Sprite slot, 0 to SPRITE_SLOTS - 1
+        pixels: (h, w) pixels in wire layout (flipped) and format fmt
+        fmt: Pixel format (PIXFMT_*), the frame format it will be drawn on
+        compress: Run-length code the pixels when that is smaller
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    height, width = pixels.shape
+    if not 0 <= slot < SPRITE_SLOTS:
+        raise ValueError(f"Sprite slot must be 0-{SPRITE_SLOTS - 1}")
+    if width * height * PIXFMT_BITS[fmt] // 8 > SPRITE_BYTES or (fmt == PIXFMT_P4 and width & 1):
+        raise ValueError(f"A {width}x{height} sprite does not fit a {SPRITE_BYTES}-byte slot")
+    flags, data = _pixel_payload(pixels, fmt, compress)
+    body = struct.pack('<BBHH', slot, 0, width, height) + data
+    return _finish(_header(PKT_SPRITE, flags) + body, frame_size)
+
+
+def build_blit(
+    slot: int, x: int, y: int, key: Optional[int] = None,
+    fmt: int = PIXFMT_RGB565, pts: Optional[int] = None, frame_size: int = 0
+) -> bytes:
+    """
+    Draw a stored sprite with its top left at display (x, y); it may lie
+    partly off the display.
+
+    Args:
+        slot: Sprite slot
+        x, y: Position in display coordinates
+        key: Transparent pixel value, or None to copy every pixel
+        fmt: Current frame format (the sprite's)
+        pts: Presentation time in host microseconds, or None
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    flags = BLIT_FLAG_KEY if key is not None else 0
+    body = struct.pack('<BBhhH', slot, flags, x, y, key or 0)
+    return _finish(_frame_header(PKT_DRAW_BLIT, fmt, pts) + body, frame_size)
+
+
+def build_scroll(
+    x: int, y: int, width: int, height: int, dx: int, dy: int,
+    fmt: int = PIXFMT_RGB565, pts: Optional[int] = None, frame_size: int = 0
+) -> bytes:
+    """
+    Move a rectangle's content dx pixels right and dy down (negative:
+    left / up), wrapping around inside it.
+
+    Args:
+        x, y, width, height: Rectangle inside the display, display coordinates
+        dx, dy: Shift in pixels
+        fmt: Current frame format
+        pts: Presentation time in host microseconds, or None
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    body = struct.pack('<HHHHhh', x, y, width, height, dx, dy)
+    return _finish(_frame_header(PKT_DRAW_SCROLL, fmt, pts) + body, frame_size)
+
+
+def build_text(
+    x: int, y: int, text: str, color: int, background: Optional[int] = None,
+    fmt: int = PIXFMT_RGB565, pts: Optional[int] = None, frame_size: int = 0
+) -> bytes:
+    """
+    Text in the built-in 5x7 font (see font.py), 6x8 pixel cells from the
+    top left at display (x, y), clipped at the display edges.
+
+    Args:
+        x, y: Position of the first cell in display coordinates
+        text: 1-255 characters (ASCII; others draw '?')
+        color: Pixel value of the dots in the current frame format
+        background: Pixel value of the rest of the cells, or None to leave it
+        fmt: Current frame format
+        pts: Presentation time in host microseconds, or None
+        frame_size: Raw frame size in bytes (for the pad rule), 0 to skip
+
+    Returns:
+        Packet bytes (not COBS-encoded)
+    """
+    data = text.encode('ascii', errors='replace')
+    if not 1 <= len(data) <= 255:
+        raise ValueError("Text must be 1-255 characters")
+    flags = TEXT_FLAG_BACKGROUND if background is not None else 0
+    body = struct.pack('<hhHHBB', x, y, color, background or 0, flags, len(data)) + data
+    return _finish(_frame_header(PKT_DRAW_TEXT, fmt, pts) + body, frame_size)
+
+
+def parse_stats(packet: bytes) -> Optional[dict]:
+    """
+    Read a decoded PKT_STATS reply from the device.
+
+    Returns:
+        Counter name (STATS_FIELDS) -> value, or None if packet is not a
+        stats reply
+    """
+    if len(packet) < HEADER_SIZE + STATS_STRUCT.size:
+        return None
+    if packet[:3] != bytes((PROTO_MAGIC, PROTO_VERSION, PKT_STATS)):
+        return None
+    return dict(zip(STATS_FIELDS, STATS_STRUCT.unpack_from(packet, HEADER_SIZE)))
+
+
+def stats_rates(prev: dict, cur: dict) -> dict:
+    """
+    Rates between two stats replies (counters wrap at 32 bits).
+
+    Args:
+        prev: Earlier parse_stats result
+        cur: Later parse_stats result
+
+    Returns:
+        rx_kbps, packets, dropped, cobs_errors, fps (frames converted),
+        refresh_hz (sweeps), decode_load and convert_load (share of Core0),
+        core1_idle (share of Core1) per second of device time, and
+        convert_max_ms for cur
+    """
+    def delta(name):
+        return (cur[name] - prev[name]) & 0xFFFFFFFF
+
+    seconds = delta('time_us') / 1e6 or 1e-6
+    cycles = seconds * cur['clk_mhz'] * 1e6 or 1.0
+    return {
+        'rx_kbps': delta('rx_bytes') * 8 / 1000 / seconds,
+        'packets': delta('packets') / seconds,
+        'dropped': delta('dropped') / seconds,
+        'cobs_errors': delta('cobs_errors') / seconds,
+        'fps': delta('frames') / seconds,
+        'refresh_hz': delta('sweeps') / seconds,
+        'decode_load': delta('decode_cycles') / cycles,
+        'convert_load': delta('convert_cycles') / cycles,
+        'core1_idle': delta('idle_cycles') / cycles,
+        'convert_max_ms': cur['convert_max_cycles'] / (cur['clk_mhz'] or 1) / 1000,
+    }
+
+
+def parse_credit(packet: bytes) -> Optional[tuple]:
+    """
+    Read a decoded PKT_CREDIT report from the device.
+
+    Returns:
+        (frames, window), or None if packet is not a credit report
+    """
+    if len(packet) < HEADER_SIZE + 3:
+        return None
+    if packet[:3] != bytes((PROTO_MAGIC, PROTO_VERSION, PKT_CREDIT)):
+        return None
+    return struct.unpack_from('<HB', packet, HEADER_SIZE)
+
+
+class FrameCredits:
+    """
+    Host side of PKT_CREDIT flow control.
+
+    Counts frame packets sent against the device's reports of frame packets
+    consumed and allows at most `window` in flight, so frames are paced by
+    how fast the device actually converts them. Until a device has reported
+    (old firmware, simulators) sending is never held back.
+    """
+
+    def __init__(self, timeout: float = 0.5):
+        """
+        Initialize with no device report yet (unpaced).
+
+        Args:
+            timeout: Seconds without a report, while frames are held back,
+                     after which the count is taken as lost (see stalled)
+        """
+        self.timeout = timeout
+        self.reset()
+
+    def reset(self):
+        """Forget the device state (after build_credit(0) or reconnect)."""
+        self.window = 0
+        self.sent = 0
+        self.done = 0
+        self._rx = b''
+        self._last_progress = time.monotonic()
+
+    @property
+    def enabled(self) -> bool:
+        """True once the device has reported a window."""
+        return self.window > 0
+
+    @property
+    def in_flight(self) -> int:
+        """Frame packets sent but not yet reported as consumed."""
+        return (self.sent - self.done) & 0xFFFF
+
+    def feed(self, data: bytes) -> List[bytes]:
+        """
+        Process bytes received from the device (any chunking).
+
+        Args:
+            data: Raw COBS stream, 0x00-delimited
+
+        Returns:
+            Decoded packets other than credit reports (e.g. PKT_STATS)
+        """
+        others = []
+        *packets, self._rx = (self._rx + data).split(b'\x00')
+        for chunk in packets:
+            packet = cobs_decode(chunk) if chunk else None
+            if not packet:
+                continue
+            credit = parse_credit(packet)
+            if credit is not None:
+                self.done, self.window = credit
+                self._last_progress = time.monotonic()
+            else:
+                others.append(packet)
+        return others
+
+    @property
+    def stalled(self) -> bool:
+        """
+        True if frames are held back and no report came within the timeout.
+
+        A report was lost or the device dropped a frame packet; the counts
+        went out of step and the caller re-syncs with a credit probe
+        (build_credit(0), then reset()).
+        """
+        return (self.enabled and self.in_flight >= self.window and
+                time.monotonic() - self._last_progress > self.timeout)
+
+    def can_send(self) -> bool:
+        """True if another frame packet may be sent now."""
+        return not self.enabled or self.in_flight < self.window
+
+    def on_sent(self):
+        """Count one frame packet handed to the device."""
+        if self.in_flight == 0:
+            self._last_progress = time.monotonic()
+        self.sent = (self.sent + 1) & 0xFFFF
+
+
+def rgb332_palette() -> np.ndarray:
+    """The fixed RGB332 colours as a (256, 3) palette (firmware default)."""
+    i = np.arange(256)
+    palette = np.empty((256, 3), dtype=np.uint8)
+    palette[:, 0] = ((i >> 5) & 0x07) * 255 // 7
+    palette[:, 1] = ((i >> 2) & 0x07) * 255 // 7
+    palette[:, 2] = (i & 0x03) * 85
+    return palette
+
+
+def rgb_to_rgb332(image: np.ndarray) -> np.ndarray:
+    """Convert an (H, W, 3) RGB888 image to (H, W) uint8 RGB332."""
+    r = image[:, :, 0] & 0xE0
+    g = (image[:, :, 1] >> 3) & 0x1C
+    b = image[:, :, 2] >> 6
+    return (r | g | b).astype(np.uint8)
+
+
+def build_delta(
+    pixels: np.ndarray,
+    previous: Optional[np.ndarray],
+    fmt: int = PIXFMT_RGB565,
+    pts: Optional[int] = None,
+    compress: bool = False
+) -> Optional[bytes]:
+    """
+    Smallest packet that turns `previous` into `pixels`.
+
+    Args:
+        pixels: New frame, (H, W) in format fmt
+        previous: Frame last sent to the device in the same format,
+                  or None if unknown (or sent in another format)
+        fmt: Pixel format (PIXFMT_*)
+        pts: Presentation time in host microseconds, or None to show at once
+        compress: Run-length code the chosen packet's pixels when smaller
+
+    Returns:
+        Packet bytes (not COBS-encoded), or None if nothing changed
+    """
+    if previous is None or previous.shape != pixels.shape:
+        return build_full_frame(pixels, fmt, pts, compress)
+
+    changed = pixels != previous
+    rows = np.flatnonzero(changed.any(axis=1))
+    if rows.size == 0:
+        return None
+    cols = np.flatnonzero(changed.any(axis=0))
+
+    height, width = pixels.shape
+    y0, y1 = int(rows[0]), int(rows[-1]) + 1
+    x0, x1 = int(cols[0]), int(cols[-1]) + 1
+    if fmt == PIXFMT_P4:
+        # Whole bytes only
+        x0 &= ~1
+        x1 += x1 & 1
+
+    # Raw sizes of each candidate (COBS overhead is proportional)
+    bits = PIXFMT_BITS[fmt]
+    full_size = width * height * bits // 8
+    rows_size = 4 + (y1 - y0) * width * bits // 8
+    rect_size = 8 + (x1 - x0) * (y1 - y0) * bits // 8
+
+    if rect_size < rows_size and rect_size < full_size:
+        return build_rect(pixels, x0, y0, x1 - x0, y1 - y0, fmt, pts, compress)
+    if rows_size < full_size:
+        return build_rows(pixels, y0, y1 - y0, fmt, pts, compress)
+    return build_full_frame(pixels, fmt, pts, compress)
+
+
+def encode_clip(
+    frames: Iterable[np.ndarray],
+    fmt: int = PIXFMT_RGB565,
+    max_bytes: Optional[int] = None,
+    compress: bool = True
+) -> tuple:
+    """
+    Record frames as a clip stream: delimited COBS packets, one frame packet
+    per frame, starting with a full frame so the loop restarts cleanly.
+
+    Args:
+        frames: (H, W) pixel arrays in wire layout (flipped) and format fmt
+        fmt: Pixel format (PIXFMT_*)
+        max_bytes: Stop before the stream would grow past this size
+        compress: Run-length code frames where that is smaller
+
+    Returns:
+        (stream bytes as stored by the device, number of frames recorded)
+    """
+    stream = bytearray()
+    count = 0
+    previous = None
+    for pixels in frames:
+        packet = build_delta(pixels, previous, fmt, compress=compress)
+        if packet is None:
+            # Unchanged frame still takes its slot: re-send one row
+            packet = build_rows(pixels, 0, 1, fmt, compress=compress)
+        encoded = cobs_encode(packet) + b'\x00'
+        if max_bytes is not None and len(stream) + len(encoded) > max_bytes:
+            break
+        stream += encoded
+        count += 1
+        previous = pixels
+    return bytes(stream), count
+
+
+def _clip_block(frame: np.ndarray, x: int, y: int, height: int, width: int) -> Optional[tuple]:
+    """Visible part of a block at (x, y): (frame slices, block slices) or None."""
+    x0, y0 = max(x, 0), max(y, 0)
+    x1, y1 = min(x + width, frame.shape[1]), min(y + height, frame.shape[0])
+    if x0 >= x1 or y0 >= y1:
+        return None
+    return ((slice(y0, y1), slice(x0, x1)),
+            (slice(y0 - y, y1 - y), slice(x0 - x, x1 - x)))
+
+
+def draw_fill(pixels: np.ndarray, x: int, y: int, width: int, height: int, color: int):
+    """
+    Apply a PKT_DRAW_FILL to a frame in wire layout, as the firmware does.
+    The draw_* functions take display coordinates (like the packets).
+    """
+    pixels[:, ::-1][y:y + height, x:x + width] = color
+
+
+def draw_blit(pixels: np.ndarray, sprite: np.ndarray, x: int, y: int, key: Optional[int] = None):
+    """Apply a PKT_DRAW_BLIT of a sprite in wire layout (see draw_fill)."""
+    view = pixels[:, ::-1]
+    src = sprite[:, ::-1]
+    clip = _clip_block(view, x, y, *src.shape)
+    if clip is None:
+        return
+    target = view[clip[0]]
+    block = src[clip[1]]
+    if key is None:
+        target[...] = block
+    else:
+        keep = block != key
+        target[keep] = block[keep]
+
+
+def draw_scroll(pixels: np.ndarray, x: int, y: int, width: int, height: int, dx: int, dy: int):
+    """Apply a PKT_DRAW_SCROLL (see draw_fill)."""
+    region = pixels[:, ::-1][y:y + height, x:x + width]
+    region[...] = np.roll(region, (dy, dx), axis=(0, 1))
+
+
+def draw_text(
+    pixels: np.ndarray, x: int, y: int, text: bytes, color: int, background: Optional[int] = None
+):
+    """Apply a PKT_DRAW_TEXT (see draw_fill)."""
+    view = pixels[:, ::-1]
+    mask = text_mask(text)
+    clip = _clip_block(view, x, y, *mask.shape)
+    if clip is None:
+        return
+    target = view[clip[0]]
+    lit = mask[clip[1]]
+    if background is not None:
+        target[~lit] = background
+    target[lit] = color
+
+
+class FrameState:
+    """
+    Display frame as the firmware holds it: one pixel format, raw pixels
+    and the uploaded palette. Used by the simulator devices.
+    """
+
+    def __init__(self, width: int, height: int):
+        """
+        Initialize a blank RGB565 frame.
+
+        Args:
+            width: Display width in pixels
+            height: Display height in pixels
+        """
+        self.width = width
+        self.height = height
+        self.format = PIXFMT_RGB565
+        self.pixels = np.zeros((height, width), dtype=np.uint16)
+        self.palette = rgb332_palette()
+        self.depth = 6
+        self.brightness = 255
+        self.luts = [gamma_lut(c) for c in range(3)]
+        self.sprites = {}  # Slot -> (format, pixels in wire layout)
+
+    def _body_pixels(
+        self, body: bytes, fmt: int, x: int, y: int, w: int, h: int, rle: bool = False
+    ) -> bool:
+        """Store a w x h block at (x, y), checking the firmware's rules."""
+        bits = PIXFMT_BITS.get(fmt)
+        if bits is None:
+            return False
+        if w == 0 or h == 0 or x + w > self.width or y + h > self.height:
+            return False
+        if fmt != self.format and (w != self.width or h != self.height):
+            return False
+        if bits == 4 and (x | w) & 1:
+            return False
+        size = w * h * bits // 8
+        if rle:
+            body = rle_decode(body, 2 if bits == 16 else 1, size)
+            if body is None:
+                return False
+        if len(body) not in (size, size + 1):
+            return False
+
+        if fmt != self.format:
+            dtype = np.uint16 if fmt == PIXFMT_RGB565 else np.uint8
+            self.pixels = np.zeros((self.height, self.width), dtype=dtype)
+            self.format = fmt
+        self.pixels[y:y + h, x:x + w] = _unpack_pixels(body[:size], w, h, fmt)
+        return True
+
+    def _sprite(self, fmt: int, body: bytes, rle: bool) -> bool:
+        """Store a PKT_SPRITE upload (a rejected one empties its slot)."""
+        if len(body) < 6:
+            return False
+        slot, _, w, h = struct.unpack_from('<BBHH', body)
+        if slot >= SPRITE_SLOTS:
+            return False
+        self.sprites.pop(slot, None)
+
+        bits = PIXFMT_BITS.get(fmt)
+        if bits is None or w == 0 or h == 0 or (bits == 4 and w & 1):
+            return False
+        size = w * h * bits // 8
+        if size > SPRITE_BYTES:
+            return False
+        data = body[6:]
+        if rle:
+            data = rle_decode(data, 2 if bits == 16 else 1, size)
+            if data is None:
+                return False
+        if len(data) not in (size, size + 1):
+            return False
+        self.sprites[slot] = (fmt, _unpack_pixels(data[:size], w, h, fmt).copy())
+        return True
+
+    def _draw(self, packet_type: int, fmt: int, body: bytes) -> bool:
+        """Execute a drawing packet, checking the firmware's rules."""
+        mask = (1 << PIXFMT_BITS[self.format]) - 1
+
+        if packet_type == PKT_DRAW_FILL and len(body) in (10, 11):
+            x, y, w, h, color = struct.unpack_from('<HHHHH', body)
+            whole = w == self.width and h == self.height
+            if w == 0 or h == 0 or x + w > self.width or y + h > self.height:
+                return False
+            if fmt != self.format:
+                if not whole or fmt not in PIXFMT_BITS:
+                    return False
+                dtype = np.uint16 if fmt == PIXFMT_RGB565 else np.uint8
+                self.pixels = np.zeros((self.height, self.width), dtype=dtype)
+                self.format = fmt
+                mask = (1 << PIXFMT_BITS[fmt]) - 1
+            draw_fill(self.pixels, x, y, w, h, color & mask)
+            return True
+
+        if fmt != self.format:
+            return False
+
+        if packet_type == PKT_DRAW_BLIT and len(body) in (8, 9):
+            slot, flags, x, y, key = struct.unpack_from('<BBhhH', body)
+            sprite = self.sprites.get(slot)
+            if sprite is None or sprite[0] != self.format:
+                return False
+            # A key outside the format's range matches no pixel
+            use_key = flags & BLIT_FLAG_KEY and key <= mask
+            draw_blit(self.pixels, sprite[1], x, y, key if use_key else None)
+            return True
+
+        if packet_type == PKT_DRAW_SCROLL and len(body) in (12, 13):
+            x, y, w, h, dx, dy = struct.unpack_from('<HHHHhh', body)
+            if w == 0 or h == 0 or x + w > self.width or y + h > self.height:
+                return False
+            draw_scroll(self.pixels, x, y, w, h, dx, dy)
+            return True
+
+        if packet_type == PKT_DRAW_TEXT and len(body) >= 10:
+            x, y, color, background, flags, length = struct.unpack_from('<hhHHBB', body)
+            if length == 0 or len(body) - 10 not in (length, length + 1):
+                return False
+            if flags & TEXT_FLAG_BACKGROUND:
+                background &= mask
+            else:
+                background = None
+            draw_text(self.pixels, x, y, body[10:10 + length], color & mask, background)
+            return True
+
+        return False
+
+    def apply(self, packet: bytes) -> bool:
+        """
+        Apply one decoded packet.
+
+        Returns:
+            True if the packet was accepted
+        """
+        # Legacy raw frame
+        if len(packet) == self.width * self.height * 2:
+            return self._body_pixels(packet, PIXFMT_RGB565, 0, 0, self.width, self.height)
+
+        if len(packet) < HEADER_SIZE:
+            return False
+        magic, version, packet_type, flags = packet[:HEADER_SIZE]
+        if magic != PROTO_MAGIC or version != PROTO_VERSION:
+            return False
+        body = packet[HEADER_SIZE:]
+        fmt = flags & PKT_FORMAT_MASK
+        rle = bool(flags & PKT_FLAG_RLE)
+        if flags & PKT_FLAG_PTS and packet_type not in FRAME_PACKETS + DRAW_PACKETS:
+            return False
+        if rle and packet_type not in FRAME_PACKETS + (PKT_SPRITE,):
+            return False
+        if flags & PKT_FLAG_PTS:
+            # Shown immediately here
+            if len(body) < 4:
+                return False
+            body = body[4:]
+
+        if packet_type == PKT_FRAME_FULL:
+            return self._body_pixels(body, fmt, 0, 0, self.width, self.height, rle)
+
+        if packet_type == PKT_FRAME_ROWS and len(body) >= 4:
+            y, h = struct.unpack_from('<HH', body)
+            return self._body_pixels(body[4:], fmt, 0, y, self.width, h, rle)
+
+        if packet_type == PKT_FRAME_RECT and len(body) >= 8:
+            x, y, w, h = struct.unpack_from('<HHHH', body)
+            return self._body_pixels(body[8:], fmt, x, y, w, h, rle)
+
+        if packet_type in DRAW_PACKETS:
+            return self._draw(packet_type, fmt, body)
+
+        if packet_type == PKT_SPRITE:
+            return self._sprite(fmt, body, rle)
+
+        if packet_type == PKT_PALETTE and len(body) >= 4:
+            first, count = struct.unpack_from('<HH', body)
+            size = count * 3
+            if count == 0 or first + count > 256 or len(body) - 4 not in (size, size + 1):
+                return False
+            entries = np.frombuffer(body[4:4 + size], dtype=np.uint8).reshape(count, 3)
+            self.palette[first:first + count] = entries
+            return True
+
+        if packet_type == PKT_DEPTH and len(body) in (1, 2):
+            if body[0] not in COLOR_DEPTHS:
+                return False
+            self.depth = body[0]
+            return True
+
+        if packet_type == PKT_LUT and len(body) >= 1 and body[0] < 3:
+            size = LUT_ENTRIES[body[0]] * 2
+            if len(body) - 1 not in (size, size + 1):
+                return False
+            self.luts[body[0]] = np.frombuffer(body[1:1 + size], dtype='<u2').copy()
+            return True
+
+        if packet_type == PKT_BRIGHTNESS and len(body) in (1, 2):
+            self.brightness = body[0]
+            return True
+
+        if packet_type == PKT_CREDIT and len(body) in (3, 4):
+            return True
+
+        if packet_type == PKT_CLOCK and len(body) in (4, 5):
+            return True
+
+        if packet_type == PKT_STATS and len(body) in (0, 1):
+            return True
+
+        return False
+
+    def to_rgb(self) -> np.ndarray:
+        """(H, W, 3) uint8 RGB in wire (horizontally flipped) order."""
+        if self.format == PIXFMT_RGB565:
+            p = self.pixels
+            rgb = np.empty((self.height, self.width, 3), dtype=np.uint8)
+            rgb[:, :, 0] = ((p >> 11) & 0x1F) << 3
+            rgb[:, :, 1] = ((p >> 5) & 0x3F) << 2
+            rgb[:, :, 2] = (p & 0x1F) << 3
+            return rgb
+        if self.format == PIXFMT_RGB332:
+            return rgb332_palette()[self.pixels]
+        return self.palette[self.pixels]
@@ -0,0 +1,264 @@
+"""
+Video Wall
+
+Drives a grid of LED matrix controllers from one host as a single
+display: the source is decoded, scaled and converted once at the size of
+the whole wall, then sliced into per-device tiles that are encoded and
+written in parallel, one writer thread per device.
+"""
+
+import queue
+import threading
+from typing import Callable, List, Optional
+
+import numpy as np
+
+from .controller import (
+    LEDMatrixController, host_time_us, DISPLAY_WIDTH, DISPLAY_HEIGHT,
+    PRESENTATION_DELAY,
+)
+from .devices.base import BaseDevice
+
+
+class TileWriter:
+    """
+    Worker thread of one wall tile: runs that tile's sends in order.
+
+    The wall hands every writer one job per frame and waits for all of
+    them before the next frame, so there is never more than one frame in
+    flight per device.
+    """
+
+    def __init__(self, name: str):
+        self._jobs: queue.Queue = queue.Queue()
+        self._ok = True
+        self._thread = threading.Thread(target=self._run, name=name, daemon=True)
+        self._thread.start()
+
+    def _run(self):
+        while True:
+            job = self._jobs.get()
+            try:
+                if job is None:
+                    return
+                try:
+                    self._ok = bool(job()) and self._ok
+                except Exception as e:
+                    print(f"{self._thread.name}: {e}")
+                    self._ok = False
+            finally:
+                self._jobs.task_done()
+
+    def submit(self, job: Callable[[], bool]):
+        """Queue a send (a function returning True on success)."""
+        self._jobs.put(job)
+
+    def wait(self) -> bool:
+        """
+        Wait until the queued sends are done.
+
+        Returns:
+            False if any of them failed since the last wait()
+        """
+        self._jobs.join()
+        ok, self._ok = self._ok, True
+        return ok
+
+    def close(self):
+        """Finish the queued sends and stop the thread."""
+        self._jobs.put(None)
+        self._thread.join()
+
+
+class VideoWall(LEDMatrixController):
+    """
+    Grid of LED matrix controllers acting as one cols x rows display.
+
+    Everything that takes images (send_frame, play_video, run_demo,
+    display_image, fill) works on the whole wall. Frames are resized and
+    converted once, each tile is a slice of the wire pixels, and the tile
+    controllers delta-encode and send their slices on their own
+    TileWriter threads, each with its own flow control. With sync, frames
+    without a presentation time get a shared one PRESENTATION_DELAY
+    ahead, so all panels flip together (every tile shares the host clock).
+
+    Settings (brightness, depth, gamma, palette) go to every tile; clips,
+    stats and drawing (fill_rect, blit, scroll, draw_text) are per device,
+    through `tiles`.
+    """
+
+    def __init__(
+        self,
+        devices: List[BaseDevice],
+        cols: int,
+        rows: int = 1,
+        tile_width: int = DISPLAY_WIDTH,
+        tile_height: int = DISPLAY_HEIGHT,
+        brightness: float = 1.0,
+        pixel_format: str = "rgb565",
+        compress: bool = True,
+        sync: bool = True
+    ):
+        """
+        Initialize a wall.
+
+        Args:
+            devices: One output device per tile, row by row from the top left
+            cols: Tiles across
+            rows: Tiles down
+            tile_width: Display width of each device in pixels
+            tile_height: Display height of each device in pixels
+            brightness: Display brightness (0.0-1.0) of every tile
+            pixel_format: Wire format for RGB images ("rgb565" or "rgb332")
+            compress: Run-length code frame packets (see LEDMatrixController)
+            sync: Timestamp untimed frames so all tiles flip at once
+        """
+        if len(devices) != cols * rows:
+            raise ValueError(f"A {cols}x{rows} wall needs {cols * rows} devices, got {len(devices)}")
+
+        super().__init__(
+            device=None,
+            width=cols * tile_width,
+            height=rows * tile_height,
+            brightness=brightness,
+            pixel_format=pixel_format,
+            compress=compress
+        )
+        self.cols = cols
+        self.rows = rows
+        self.sync = sync
+        self.tiles = [
+            LEDMatrixController(
+                device,
+                width=tile_width,
+                height=tile_height,
+                brightness=brightness,
+                pixel_format=pixel_format,
+                compress=compress
+            )
+            for device in devices
+        ]
+        self._writers: List[TileWriter] = []
+
+    def connect(self, configure: bool = True) -> bool:
+        """Connect every tile (see LEDMatrixController.connect) and start its writer."""
+        ok = all([tile.connect(configure) for tile in self.tiles])
+        if not self._writers:
+            self._writers = [TileWriter(f"tile{i}") for i in range(len(self.tiles))]
+        return ok
+
+    def disconnect(self):
+        """Finish pending sends, stop the writers and disconnect every tile."""
+        for writer in self._writers:
+            writer.close()
+        self._writers = []
+        for tile in self.tiles:
+            tile.disconnect()
+
+    @property
+    def flow_control(self) -> bool:
+        """True if every tile paces frames with credit reports."""
+        return all(tile.flow_control for tile in self.tiles)
+
+    def _tile_slice(self, index: int, flipped: bool) -> tuple:
+        """Row/column slices of a tile in wall pixels (flipped: wire layout)."""
+        tile = self.tiles[index]
+        row, col = divmod(index, self.cols)
+        if flipped:
+            # Wire pixels are mirrored, so the columns are in reverse order
+            col = self.cols - 1 - col
+        return (slice(row * tile.height, (row + 1) * tile.height),
+                slice(col * tile.width, (col + 1) * tile.width))
+
+    def _dispatch(self, jobs: List[Callable[[], bool]]) -> bool:
+        """
+        Hand one job to every tile writer once the previous frame is done.
+
+        Returns:
+            False if a tile failed its previous job
+        """
+        ok = all([writer.wait() for writer in self._writers])
+        for writer, job in zip(self._writers, jobs):
+            writer.submit(job)
+        return ok
+
+    def wait(self) -> bool:
+        """Wait until every tile has sent its last frame."""
+        return all([writer.wait() for writer in self._writers])
+
+    def _shared_pts(self, pts: Optional[int]) -> Optional[int]:
+        """Presentation time for a wall frame (shared one when syncing)."""
+        if pts is None and self.sync:
+            return (host_time_us() + int(PRESENTATION_DELAY * 1e6)) & 0xFFFFFFFF
+        return pts
+
+    def _send_pixels(
+        self, pixels: np.ndarray, pts: Optional[int] = None, wait_ack: bool = True,
+        out: Optional[np.ndarray] = None
+    ) -> bool:
+        """
+        Slice a wall frame in wire layout into tiles and send them in parallel.
+
+        The tiles encode into their own packets, so `out` is not used.
+        Returns as soon as the tiles have their slices; the result reports
+        the previous frame.
+        """
+        pts = self._shared_pts(pts)
+
+        def job(tile: LEDMatrixController, block: np.ndarray):
+            return lambda: tile._send_pixels(block, pts, wait_ack)
+
+        ok = self._dispatch([
+            job(tile, pixels[self._tile_slice(i, flipped=True)])
+            for i, tile in enumerate(self.tiles)
+        ])
+        self._update_fps()
+        return ok
+
+    def send_indexed(
+        self, indices: np.ndarray, bits: int = 8, pts: Optional[int] = None
+    ) -> bool:
+        """Send a paletted wall frame (see LEDMatrixController.send_indexed)."""
+        if indices.shape != (self.height, self.width):
+            raise ValueError(f"Indexed frame must be {self.width}x{self.height}")
+        pts = self._shared_pts(pts)
+
+        def job(tile: LEDMatrixController, block: np.ndarray):
+            return lambda: tile.send_indexed(block, bits, pts)
+
+        ok = self._dispatch([
+            job(tile, indices[self._tile_slice(i, flipped=False)])
+            for i, tile in enumerate(self.tiles)
+        ])
+        self._update_fps()
+        return ok
+
+    def _send_draw(self, packet: bytes, draw) -> bool:
+        """Drawing packets address one device's frame: draw on `tiles` instead."""
+        raise NotImplementedError("Draw on the wall's tiles (wall.tiles[i].draw_text(...))")
+
+    def _broadcast(self, send: Callable[[LEDMatrixController], bool]) -> bool:
+        """Apply a setting to every tile, after its pending frame."""
+        self.wait()
+        return all([send(tile) for tile in self.tiles])
+
+    def sync_clock(self) -> bool:
+        """Send the host time to every tile."""
+        return self._broadcast(lambda tile: tile.sync_clock())
+
+    def set_palette(self, colors: np.ndarray, first: int = 0) -> bool:
+        """Upload palette entries to every tile."""
+        return self._broadcast(lambda tile: tile.set_palette(colors, first))
+
+    def set_brightness(self, brightness: float) -> bool:
+        """Set the brightness of every tile."""
+        self.brightness = max(0.0, min(1.0, brightness))
+        return self._broadcast(lambda tile: tile.set_brightness(brightness))
+
+    def set_lut(self, channel: int, levels: np.ndarray) -> bool:
+        """Upload one channel's curve to every tile."""
+        return self._broadcast(lambda tile: tile.set_lut(channel, levels))
+
+    def set_depth(self, depth: int) -> bool:
+        """Set the colour depth of every tile."""
+        return self._broadcast(lambda tile: tile.set_depth(depth))
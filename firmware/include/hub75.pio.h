@@ -9,10 +9,19 @@
 #define HUB75_PIO_H
 
 #include <hardware/pio.h>
+#include "hub75_config.h"
+
+// OUT bit counts encode 32 as 0
+#define HUB75_OUT_BITS(n)   ((n) & 0x1f)
+
+// Delay field of programs with 1 / 2 side-set bits (clock profiles,
+// see hub75_config.h)
+#define HUB75_DELAY1(d)     (((d) & 0xf) << 8)
+#define HUB75_DELAY2(d)     (((d) & 0x7) << 8)
 
 // ============================================
 // hub75_data program
-// Shifts out 6-bit RGB data with clock side-set
+// Shifts out RGB_PINS bits of RGB data (6 per chain) with clock side-set
 // ============================================
 
 #define hub75_data_wrap_target 0
@@ -21,8 +30,10 @@
 static const uint16_t hub75_data_program_instructions[] = {
     //     .wrap_target
     0x80a0, //  0: pull   block           side 0        ; get 32-bit data from FIFO
-    0x6706, //  1: out    pins, 6         side 0 [7]    ; output 6 bits, data setup time
-    0x1700, //  2: jmp    0               side 1 [7]    ; CLK HIGH, hold for shift register
+    0x6000 | HUB75_DELAY1(PIO_CLK_DELAY) | HUB75_OUT_BITS(RGB_PINS),
+            //  1: out    pins, RGB_PINS  side 0 [PIO_CLK_DELAY] ; output RGB bits, data setup time
+    0x1000 | HUB75_DELAY1(PIO_CLK_DELAY),
+            //  2: jmp    0               side 1 [PIO_CLK_DELAY] ; CLK HIGH, hold for shift register
     //     .wrap
 };
 
@@ -45,14 +56,14 @@ static inline pio_sm_config hub75_data_program_get_default_config(uint offset) {
  * @param pio    PIO instance (pio0 or pio1)
  * @param sm     State machine number (0-3)
  * @param offset Program offset in instruction memory
- * @param rgb_base_pin First RGB data pin (6 consecutive pins)
+ * @param rgb_base_pin First RGB data pin (RGB_PINS consecutive pins)
  * @param clock_pin Clock pin (side-set)
  */
 static inline void hub75_data_program_init(PIO pio, uint sm, uint offset,
                                             uint rgb_base_pin, uint clock_pin) {
-    // Configure 6 consecutive pins for RGB data
-    pio_sm_set_consecutive_pindirs(pio, sm, rgb_base_pin, 6, true);
-    for (uint i = rgb_base_pin; i < rgb_base_pin + 6; ++i) {
+    // Configure RGB_PINS consecutive pins for RGB data
+    pio_sm_set_consecutive_pindirs(pio, sm, rgb_base_pin, RGB_PINS, true);
+    for (uint i = rgb_base_pin; i < rgb_base_pin + RGB_PINS; ++i) {
         pio_gpio_init(pio, i);
     }
     
@@ -63,24 +74,297 @@ static inline void hub75_data_program_init(PIO pio, uint sm, uint offset,
     // Get default config
     pio_sm_config c = hub75_data_program_get_default_config(offset);
     
-    // Set OUT pins (6 RGB data pins)
-    sm_config_set_out_pins(&c, rgb_base_pin, 6);
+    // Set OUT pins (RGB data pins)
+    sm_config_set_out_pins(&c, rgb_base_pin, RGB_PINS);
     
     // Set side-set pin (clock)
     sm_config_set_sideset_pins(&c, clock_pin);
     
-    // Shift right, autopull at 6 bits
-    sm_config_set_out_shift(&c, true, true, 6);
+    // Shift right, autopull at RGB_PINS bits
+    sm_config_set_out_shift(&c, true, true, RGB_PINS);
     
     // Join FIFO for TX only
     sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
     
-    // Run at full speed
-    sm_config_set_clkdiv(&c, 1.0f);
+    // Shift clock: see PIO_CLKDIV / PIO_CLK_DELAY
+    sm_config_set_clkdiv(&c, PIO_CLKDIV);
     
     // Initialize and enable
     pio_sm_init(pio, sm, offset, &c);
     pio_sm_set_enabled(pio, sm, true);
 }
 
+// ============================================
+// hub75_data_packed program
+// Shifts packed plane rows: 32 / SHIFT_PIXEL_BITS pixels per FIFO word,
+// LSB first. Each pixel is one plane element (8/16/32 bits); only the low
+// RGB_PINS bits reach the pins.
+// ============================================
+
+#define hub75_data_packed_wrap_target 0
+#define hub75_data_packed_wrap 1
+
+static const uint16_t hub75_data_packed_program_instructions[] = {
+    //     .wrap_target
+    0x6000 | HUB75_DELAY1(PIO_CLK_DELAY) | HUB75_OUT_BITS(SHIFT_PIXEL_BITS),
+            //  0: out    pins, SHIFT_PIXEL_BITS side 0 [PIO_CLK_DELAY] ; autopull, RGB_PINS bits reach pins
+    0xb042 | HUB75_DELAY1(PIO_CLK_DELAY),
+            //  1: nop                    side 1 [PIO_CLK_DELAY] ; CLK HIGH, hold for shift register
+    //     .wrap
+};
+
+static const struct pio_program hub75_data_packed_program = {
+    .instructions = hub75_data_packed_program_instructions,
+    .length = 2,
+    .origin = -1,
+};
+
+static inline pio_sm_config hub75_data_packed_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + hub75_data_packed_wrap_target, offset + hub75_data_packed_wrap);
+    sm_config_set_sideset(&c, 1, false, false);
+    return c;
+}
+
+/**
+ * Initialize the hub75_data_packed PIO program
+ *
+ * @param pio    PIO instance (pio0 or pio1)
+ * @param sm     State machine number (0-3)
+ * @param offset Program offset in instruction memory
+ * @param rgb_base_pin First RGB data pin (RGB_PINS consecutive pins)
+ * @param clock_pin Clock pin (side-set)
+ */
+static inline void hub75_data_packed_program_init(PIO pio, uint sm, uint offset,
+                                                   uint rgb_base_pin, uint clock_pin) {
+    pio_sm_set_consecutive_pindirs(pio, sm, rgb_base_pin, RGB_PINS, true);
+    for (uint i = rgb_base_pin; i < rgb_base_pin + RGB_PINS; ++i) {
+        pio_gpio_init(pio, i);
+    }
+
+    pio_sm_set_consecutive_pindirs(pio, sm, clock_pin, 1, true);
+    pio_gpio_init(pio, clock_pin);
+
+    pio_sm_config c = hub75_data_packed_program_get_default_config(offset);
+
+    // OUT drives only the RGB pins, the spare bits are discarded
+    sm_config_set_out_pins(&c, rgb_base_pin, RGB_PINS);
+    sm_config_set_sideset_pins(&c, clock_pin);
+
+    // Shift right, autopull every 32 bits
+    sm_config_set_out_shift(&c, true, true, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&c, PIO_CLKDIV);
+
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+// ============================================
+// hub75_oe program
+// Hardware-timed BCM on-time for the CPU-sequenced PIO refresh.
+// One FIFO word per row: OE on-time in cycles - 1
+// Side-set: OE (active LOW), held high (blank) while waiting for a word
+// ============================================
+
+#define hub75_oe_wrap_target 0
+#define hub75_oe_wrap 2
+
+static const uint16_t hub75_oe_program_instructions[] = {
+    //     .wrap_target
+    0x90a0, //  0: pull   block           side 1        ; blanked, get on-time
+    0x7020, //  1: out    x, 32           side 1
+    0x0042, //  2: jmp    x--, 2          side 0        ; OE LOW for x+1 cycles
+    //     .wrap
+};
+
+static const struct pio_program hub75_oe_program = {
+    .instructions = hub75_oe_program_instructions,
+    .length = 3,
+    .origin = -1,
+};
+
+static inline pio_sm_config hub75_oe_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + hub75_oe_wrap_target, offset + hub75_oe_wrap);
+    sm_config_set_sideset(&c, 1, false, false);
+    return c;
+}
+
+/**
+ * Initialize the hub75_oe PIO program
+ *
+ * @param pio    PIO instance (pio0 or pio1)
+ * @param sm     State machine number (0-3)
+ * @param offset Program offset in instruction memory
+ * @param oe_pin OE pin (side-set)
+ */
+static inline void hub75_oe_program_init(PIO pio, uint sm, uint offset, uint oe_pin) {
+    // OE high (blank) until the first on-time is pushed
+    pio_sm_set_pins_with_mask(pio, sm, 1u << oe_pin, 1u << oe_pin);
+    pio_sm_set_consecutive_pindirs(pio, sm, oe_pin, 1, true);
+    pio_gpio_init(pio, oe_pin);
+
+    pio_sm_config c = hub75_oe_program_get_default_config(offset);
+    sm_config_set_sideset_pins(&c, oe_pin);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&c, 1.0f);
+
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+// ============================================
+// hub75_data_chain program (DMA-chained refresh)
+// Shifts one row per handshake with hub75_row:
+//   IRQ 4: data -> row  (row shifted, ready to latch)
+//   IRQ 5: row  -> data (row latched, next row may be shifted while it is lit)
+// Pixels are packed like hub75_data_packed.
+// Y holds (pixels per row - 1), preloaded by the init function
+// ============================================
+
+#define hub75_data_chain_wrap_target 0
+#define hub75_data_chain_wrap 4
+
+static const uint16_t hub75_data_chain_program_instructions[] = {
+    //     .wrap_target
+    0xa022, //  0: mov    x, y            side 0        ; pixel counter
+    0x6000 | HUB75_DELAY1(PIO_CLK_DELAY) | HUB75_OUT_BITS(SHIFT_PIXEL_BITS),
+            //  1: out    pins, SHIFT_PIXEL_BITS side 0 [PIO_CLK_DELAY] ; autopull, RGB_PINS bits reach pins
+    0x1041 | HUB75_DELAY1(PIO_CLK_DELAY),
+            //  2: jmp    x--, 1          side 1 [PIO_CLK_DELAY] ; CLK HIGH, hold for shift register
+    0xc004, //  3: irq    nowait 4        side 0        ; row complete -> hub75_row
+    0x20c5, //  4: wait   1 irq, 5        side 0        ; wait until row has been latched
+    //     .wrap
+};
+
+static const struct pio_program hub75_data_chain_program = {
+    .instructions = hub75_data_chain_program_instructions,
+    .length = 5,
+    .origin = -1,
+};
+
+static inline pio_sm_config hub75_data_chain_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + hub75_data_chain_wrap_target, offset + hub75_data_chain_wrap);
+    sm_config_set_sideset(&c, 1, false, false);
+    return c;
+}
+
+/**
+ * Initialize the hub75_data_chain PIO program
+ *
+ * @param pio    PIO instance (pio0 or pio1)
+ * @param sm     State machine number (0-3)
+ * @param offset Program offset in instruction memory
+ * @param rgb_base_pin First RGB data pin (RGB_PINS consecutive pins)
+ * @param clock_pin Clock pin (side-set)
+ * @param row_pixels Pixels shifted per row (whole FIFO words)
+ */
+static inline void hub75_data_chain_program_init(PIO pio, uint sm, uint offset,
+                                                  uint rgb_base_pin, uint clock_pin,
+                                                  uint row_pixels) {
+    pio_sm_set_consecutive_pindirs(pio, sm, rgb_base_pin, RGB_PINS, true);
+    for (uint i = rgb_base_pin; i < rgb_base_pin + RGB_PINS; ++i) {
+        pio_gpio_init(pio, i);
+    }
+
+    pio_sm_set_consecutive_pindirs(pio, sm, clock_pin, 1, true);
+    pio_gpio_init(pio, clock_pin);
+
+    pio_sm_config c = hub75_data_chain_program_get_default_config(offset);
+    sm_config_set_out_pins(&c, rgb_base_pin, RGB_PINS);
+    sm_config_set_sideset_pins(&c, clock_pin);
+
+    // OUT drives only the RGB pins, the spare bits are discarded
+    // Shift right, autopull every 32 bits
+    sm_config_set_out_shift(&c, true, true, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&c, PIO_CLKDIV);
+
+    pio_sm_init(pio, sm, offset, &c);
+
+    // Preload Y with the row length, leaving the OSR empty for autopull
+    pio_sm_put(pio, sm, row_pixels - 1);
+    pio_sm_exec(pio, sm, pio_encode_pull(false, false));
+    pio_sm_exec(pio, sm, pio_encode_out(pio_y, 32));
+
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+// ============================================
+// hub75_row program (DMA-chained refresh)
+// Drives row address, LAT and OE for each row shifted by hub75_data_chain.
+// The data SM is released right after the latch, so the next row shifts in
+// during this row's on-time; the address only changes while blanked.
+// One FIFO word per row: [31:5] OE on-time in cycles - 2, [4:0] row address
+// Side-set: bit0 = LAT, bit1 = OE (OE is active LOW)
+// ============================================
+
+#define hub75_row_wrap_target 0
+#define hub75_row_wrap 5
+
+static const uint16_t hub75_row_program_instructions[] = {
+    //     .wrap_target
+    0x90a0, //  0: pull   block           side 2        ; blanked, get next row word
+    0x30c4, //  1: wait   1 irq, 4        side 2        ; wait for row data
+    0x7005 | HUB75_DELAY2(PIO_LAT_DELAY),
+            //  2: out    pins, 5         side 2 [PIO_LAT_DELAY] ; row address, settle
+    0x783b | HUB75_DELAY2(PIO_LAT_DELAY),
+            //  3: out    x, 27           side 3 [PIO_LAT_DELAY] ; LAT pulse, load on-time
+    0xc005, //  4: irq    nowait 5        side 0        ; OE LOW, release data SM
+    0x0045, //  5: jmp    x--, 5          side 0        ; OE LOW for x+2 cycles
+    //     .wrap
+};
+
+static const struct pio_program hub75_row_program = {
+    .instructions = hub75_row_program_instructions,
+    .length = 6,
+    .origin = -1,
+};
+
+static inline pio_sm_config hub75_row_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + hub75_row_wrap_target, offset + hub75_row_wrap);
+    sm_config_set_sideset(&c, 2, false, false);
+    return c;
+}
+
+/**
+ * Initialize the hub75_row PIO program
+ *
+ * @param pio    PIO instance (pio0 or pio1)
+ * @param sm     State machine number (0-3)
+ * @param offset Program offset in instruction memory
+ * @param addr_base_pin First row address pin (consecutive)
+ * @param addr_pins Number of row address pins (max 5)
+ * @param latch_pin LAT pin (side-set), OE must be latch_pin + 1
+ */
+static inline void hub75_row_program_init(PIO pio, uint sm, uint offset,
+                                          uint addr_base_pin, uint addr_pins,
+                                          uint latch_pin) {
+    pio_sm_set_consecutive_pindirs(pio, sm, addr_base_pin, addr_pins, true);
+    for (uint i = addr_base_pin; i < addr_base_pin + addr_pins; ++i) {
+        pio_gpio_init(pio, i);
+    }
+
+    // LAT low, OE high (blank) until the first row is latched
+    pio_sm_set_pins_with_mask(pio, sm, 2u << latch_pin, 3u << latch_pin);
+    pio_sm_set_consecutive_pindirs(pio, sm, latch_pin, 2, true);
+    pio_gpio_init(pio, latch_pin);
+    pio_gpio_init(pio, latch_pin + 1);
+
+    pio_sm_config c = hub75_row_program_get_default_config(offset);
+    sm_config_set_out_pins(&c, addr_base_pin, addr_pins);
+    sm_config_set_sideset_pins(&c, latch_pin);
+
+    // Shift right: address bits first, then on-time
+    sm_config_set_out_shift(&c, true, false, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&c, 1.0f);
+
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_set_enabled(pio, sm, true);
+}
+
 #endif // HUB75_PIO_H
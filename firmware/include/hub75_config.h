@@ -12,7 +12,10 @@
 // ============================================
 // Display Configuration
 // ============================================
+// Logical display (the frame the host sends)
+#ifndef DISPLAY_WIDTH
 #define DISPLAY_WIDTH   128
+#endif
 
 // Display height: 32 or 64 (configurable via build flags)
 // Use -D DISPLAY_HEIGHT=64 in platformio.ini for 128x64 panels
@@ -20,35 +23,167 @@
 #define DISPLAY_HEIGHT  32
 #endif
 
-#define SCAN_ROWS       (DISPLAY_HEIGHT / 2)  // 16 for 32-row, 32 for 64-row
+// Parallel chains: 1-3 HUB75 chains, each on its own 6 RGB pins, shifted
+// together with shared CLK/LAT/OE/address. Chain n drives the n-th band
+// of DISPLAY_HEIGHT / HUB75_CHAINS rows.
+#ifndef HUB75_CHAINS
+#define HUB75_CHAINS    1
+#endif
+
+// ============================================
+// Panel layout (see "Panel mapping" in main.cpp)
+// ============================================
+// Default: each chain is one plain 1/(height/2) scan panel row. For other
+// layouts set the PANEL_* values together with DISPLAY_WIDTH/HEIGHT; they
+// describe one chain, all chains use the same layout.
+#ifndef PANEL_WIDTH
+#define PANEL_WIDTH     DISPLAY_WIDTH
+#endif
+#ifndef PANEL_HEIGHT
+#define PANEL_HEIGHT    (DISPLAY_HEIGHT / HUB75_CHAINS)
+#endif
+
+// Panels in the chain, arranged as PANEL_COLS x PANEL_ROWS in chain order
+#ifndef PANEL_COLS
+#define PANEL_COLS      1
+#endif
+#ifndef PANEL_ROWS
+#define PANEL_ROWS      1
+#endif
+#define PANEL_CHAIN     (PANEL_COLS * PANEL_ROWS)
+
+// 1: every other panel row runs back the other way, mounted upside down
+#ifndef PANEL_SERPENTINE
+#define PANEL_SERPENTINE 0
+#endif
+
+// Whole-display rotation in degrees (0, 90, 180, 270)
+#ifndef PANEL_ROTATION
+#define PANEL_ROTATION  0
+#endif
+
+// Scan: address lines drive SCAN_ROWS rows per half panel at once
+// (4 = 1/4, 8 = 1/8, 16 = 1/16, 32 = 1/32 scan)
+#ifndef SCAN_ROWS
+#define SCAN_ROWS       (PANEL_HEIGHT / 2)  // 16 for 32-row, 32 for 64-row
+#endif
+
+// Outdoor panels below 1/(height/2) scan shift several rows per address in
+// blocks of PANEL_SCAN_CHUNK pixels, alternating between the rows
+#ifndef PANEL_SCAN_CHUNK
+#define PANEL_SCAN_CHUNK PANEL_WIDTH
+#endif
 
-// Color depth for BCM (Binary Code Modulation)
+// Pixels shifted per address along each chain (plane row length)
+#define SHIFT_WIDTH     (DISPLAY_WIDTH * DISPLAY_HEIGHT / (2 * SCAN_ROWS * HUB75_CHAINS))
+
+// Data pins driven per shift clock, and bits stored per shift column
+// (one plane element: 8 for 6 pins, 16 for 12, 32 for 18)
+#define RGB_PINS        (6 * HUB75_CHAINS)
+#define SHIFT_PIXEL_BITS (HUB75_CHAINS == 1 ? 8 : HUB75_CHAINS == 2 ? 16 : 32)
+
+// Color depth for BCM (Binary Code Modulation): 4, 6, 8 or 10 bits
+// This is the maximum depth (plane buffers are sized for it); PKT_DEPTH can
+// select any of those values up to it at runtime.
+// Use -D COLOR_DEPTH=10 in platformio.ini for photo-grade gradients
+#ifndef COLOR_DEPTH
 #define COLOR_DEPTH     6   // 6-bit = 64 levels per color
+#endif
+
+// BCM LSB on-time in clk_sys cycles; plane n is shown for BCM_LSB_CYCLES << n.
+// 0 = 1us at the running system clock
+#ifndef BCM_LSB_CYCLES
+#define BCM_LSB_CYCLES  0
+#endif
+
+// ============================================
+// Clock profiles (PIO shift timing)
+// ============================================
+// The shift clock is clk_sys / PIO_CLKDIV / (2 * (PIO_CLK_DELAY + 1)).
+// clk_sys itself is set per environment with board_build.f_cpu; each
+// profile names the clock it was tuned for (reported by HUB75_SELFTEST)
+// and the delays that go with it:
+//   0: stock 133 MHz, CLK 8.3 MHz
+//   1: 200 MHz, CLK 12.5 MHz
+//   2: 250 MHz, CLK 15.6 MHz
+//   3: 250 MHz, CLK 25 MHz (panels with fast shift registers, short cables)
+// LAT / address settle time of the DMA-chained refresh is PIO_LAT_DELAY + 1
+// cycles, kept near 30 ns.
+#ifndef HUB75_CLOCK_PROFILE
+#define HUB75_CLOCK_PROFILE 0
+#endif
+
+#if HUB75_CLOCK_PROFILE == 1
+#define PROFILE_SYS_MHZ     200
+#define PROFILE_CLK_DELAY   7
+#define PROFILE_LAT_DELAY   5
+#elif HUB75_CLOCK_PROFILE == 2
+#define PROFILE_SYS_MHZ     250
+#define PROFILE_CLK_DELAY   7
+#define PROFILE_LAT_DELAY   7
+#elif HUB75_CLOCK_PROFILE == 3
+#define PROFILE_SYS_MHZ     250
+#define PROFILE_CLK_DELAY   4
+#define PROFILE_LAT_DELAY   7
+#else
+#define PROFILE_SYS_MHZ     133
+#define PROFILE_CLK_DELAY   7
+#define PROFILE_LAT_DELAY   3
+#endif
+
+// Data SM delay per clock half-period (0-15)
+#ifndef PIO_CLK_DELAY
+#define PIO_CLK_DELAY       PROFILE_CLK_DELAY
+#endif
+
+// Row SM delay per address / LAT step (0-7, DMA-chained refresh)
+#ifndef PIO_LAT_DELAY
+#define PIO_LAT_DELAY       PROFILE_LAT_DELAY
+#endif
+
+// Data SM clock divider (1.0 = clk_sys)
+#ifndef PIO_CLKDIV
+#define PIO_CLKDIV          1.0f
+#endif
+
+#if PIO_CLK_DELAY < 0 || PIO_CLK_DELAY > 15 || PIO_LAT_DELAY < 0 || PIO_LAT_DELAY > 7
+#error "PIO_CLK_DELAY must be 0-15 and PIO_LAT_DELAY 0-7"
+#endif
 
 // ============================================
 // Pin Configuration
 // ============================================
-// RGB Data pins (must be consecutive for PIO)
+// RGB Data pins (must be consecutive for PIO): R0,G0,B0,R1,G1,B1 of
+// chain 0, then the same 6 for each further chain
+#if HUB75_CHAINS == 3
+// 18 data pins do not leave 8 consecutive ones above them on a Pico:
+// address lines go below the data, CLK/LAT/OE to GP26-28
+#define PIN_ADDR_A      0
+#define PIN_R0          5
+#define PIN_CLK         26
+#define PIN_LAT         27
+#define PIN_OE          28
+#else
 #define PIN_R0          0
-#define PIN_G0          1
-#define PIN_B0          2
-#define PIN_R1          3
-#define PIN_G1          4
-#define PIN_B1          5
-
-// Control pins
-#define PIN_CLK         6
-#define PIN_LAT         7
-#define PIN_OE          8
+#define PIN_CLK         (PIN_R0 + RGB_PINS)     // GP6 (1 chain) / GP12 (2 chains)
+#define PIN_LAT         (PIN_CLK + 1)
+#define PIN_OE          (PIN_CLK + 2)
+#define PIN_ADDR_A      (PIN_CLK + 3)           // GP9 (1 chain) / GP15 (2 chains)
+#endif
+#define PIN_G0          (PIN_R0 + 1)
+#define PIN_B0          (PIN_R0 + 2)
+#define PIN_R1          (PIN_R0 + 3)
+#define PIN_G1          (PIN_R0 + 4)
+#define PIN_B1          (PIN_R0 + 5)
 
 // Row address pins (consecutive)
-#define PIN_ADDR_A      9
-#define PIN_ADDR_B      10
-#define PIN_ADDR_C      11
-#define PIN_ADDR_D      12
-// #define PIN_ADDR_E   13  // For 64-row panels
+#define PIN_ADDR_B      (PIN_ADDR_A + 1)
+#define PIN_ADDR_C      (PIN_ADDR_A + 2)
+#define PIN_ADDR_D      (PIN_ADDR_A + 3)
+#define PIN_ADDR_E      (PIN_ADDR_A + 4)  // For 1/32 scan
 
-#define N_ADDR_PINS     4
+// Address lines in use: A-B for 1/4 scan up to A-E for 1/32
+#define N_ADDR_PINS     (SCAN_ROWS > 16 ? 5 : SCAN_ROWS > 8 ? 4 : SCAN_ROWS > 4 ? 3 : 2)
 
 // ============================================
 // Buffer sizes
@@ -56,10 +191,54 @@
 // Frame size in bytes: 128x32=8KB, 128x64=16KB
 #define FRAME_SIZE_RGB565   (DISPLAY_WIDTH * DISPLAY_HEIGHT * 2)
 
-// COBS encoding overhead: 1 byte per 254 bytes + 1
-// Max encoded size: FRAME_SIZE + ceil(FRAME_SIZE/254) + 1
-// 128x32: 8192 + 33 = 8225 -> 8300 with margin
-// 128x64: 16384 + 65 = 16449 -> 16600 with margin
-#define RECV_BUFFER_SIZE    (FRAME_SIZE_RGB565 + (FRAME_SIZE_RGB565 / 254) + 200)
+// Packets are decoded in place into a frame slot (no receive staging).
+// Core0 decodes into one slot while older ones are converted, so receiving
+// only waits when every slot is queued. 1 = convert before receiving on.
+#ifndef FRAME_SLOTS
+#define FRAME_SLOTS         2
+#endif
+
+// Scan rows converted per USB chunk while a queued frame is converting
+#ifndef CONVERT_BAND_ROWS
+#define CONVERT_BAND_ROWS   2
+#endif
+
+// Frame packets a host may have in flight (PKT_CREDIT window): one being
+// decoded while the others are queued for conversion
+#ifndef FRAME_CREDITS
+#define FRAME_CREDITS       FRAME_SLOTS
+#endif
+
+// Presentation times further ahead than this are ignored (frame shown at once)
+#ifndef PTS_MAX_AHEAD_US
+#define PTS_MAX_AHEAD_US    2000000
+#endif
+
+// Flash clip slots (HUB75_USE_CLIPS): the filesystem region set by
+// board_build.filesystem_size is split evenly between them
+#ifndef CLIP_SLOTS
+#define CLIP_SLOTS          4
+#endif
+
+// Sprite cache (PKT_SPRITE / PKT_DRAW_BLIT): slots and bytes per slot
+// (2 KB = 32x32 RGB565 or 45x45 at 8 bits)
+#ifndef SPRITE_SLOTS
+#define SPRITE_SLOTS        8
+#endif
+#ifndef SPRITE_BYTES
+#define SPRITE_BYTES        2048
+#endif
+
+// RAM for the large buffers: BCM planes (2 x phase sets), frame slots and
+// sprites. 264 KB SRAM less the core, USB stack, stacks and smaller tables;
+// configurations above it fail at compile time instead of at link.
+#ifndef RAM_BUFFERS_MAX
+#define RAM_BUFFERS_MAX     (200 * 1024)
+#endif
+
+// USB receive chunk: matches CFG_TUD_CDC_EP_BUFSIZE (tusb_config.h)
+#ifndef RX_CHUNK_SIZE
+#define RX_CHUNK_SIZE       512
+#endif
 
 #endif // HUB75_CONFIG_H
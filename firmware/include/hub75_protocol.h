@@ -0,0 +1,317 @@
+/**
+ * HUB75 LED Panel Driver for RP2040 (PlatformIO/Arduino)
+ *
+ * Host protocol definitions
+ *
+ * Every packet is COBS-encoded and terminated by 0x00. A decoded packet is
+ * either:
+ *   - a legacy raw RGB565 frame (exactly FRAME_SIZE_RGB565 bytes), or
+ *   - a versioned packet: pkt_header_t followed by a type-specific body.
+ *
+ * Versioned packets must never decode to exactly FRAME_SIZE_RGB565 bytes;
+ * a host appends one 0x00 pad byte if it would, and the firmware accepts
+ * (and ignores) that one trailing byte.
+ *
+ * The firmware decodes packets as they stream in, so it tells the two apart
+ * by the first bytes: anything not starting with PROTO_MAGIC, PROTO_VERSION
+ * is taken as a legacy frame (a legacy frame whose first pixel is 0x01A5 is
+ * therefore rejected; current hosts only send versioned packets).
+ *
+ * All multi-byte fields are little-endian. Pixel data is row-major, in the
+ * same (horizontally flipped) order as the legacy raw frame, in the pixel
+ * format given by the low bits of pkt_header_t.flags (0 = RGB565).
+ *
+ * The display holds one frame in one pixel format. A FULL/ROWS/RECT packet
+ * in another format than the current one must cover the whole frame. P4
+ * packs two pixels per byte (low nibble first), so P4 rectangles need an
+ * even x and width. Indexed formats look up the palette set by PKT_PALETTE
+ * (RGB332 colours until one is uploaded); changing it recolours the frame.
+ *
+ * PKT_DEPTH trades colour depth for refresh rate at runtime: 4, 6, 8 or 10
+ * bits per channel, up to the COLOR_DEPTH the firmware was built with.
+ * Anything else is rejected and the current depth is kept.
+ *
+ * PKT_BRIGHTNESS scales every plane's OE on-time (0 = off, 255 = full) in
+ * the refresh engine; the frame keeps its full depth and is not reconverted.
+ *
+ * PKT_LUT replaces the curve of one channel for RGB565 frames: one 16-bit
+ * linear level (0-65535, reduced to the active depth) per component value,
+ * 32 entries for R and B, 64 for G. It takes the place of the boot-time
+ * gamma 2.2 curve, so per-panel calibration costs nothing per frame.
+ * Palette colours (indexed formats) keep the gamma curve; hosts correct
+ * those in the uploaded palette.
+ *
+ * PKT_CREDIT is the flow control packet, one of the two the firmware
+ * sends. Once a frame packet (FULL/ROWS/RECT or legacy, accepted or not)
+ * has been converted, the firmware reports the running count of frame
+ * packets it has consumed and its window: how many frame packets a host
+ * may have outstanding (sent, not yet counted). A PKT_CREDIT from the host
+ * sets the count (its window is ignored) and is answered at once; hosts
+ * send one with frames = 0 on connect to detect support and align counts.
+ * Reports go back on the interface the packet came in on. One that finds
+ * the IN FIFO full is dropped, and the next report carries the newer count.
+ *
+ * Presentation timing: PKT_CLOCK gives the firmware the host's clock (a
+ * free-running microsecond counter, wrapping at 32 bits). A frame packet
+ * with PKT_FLAG_PTS carries a pkt_pts_t right after the header, before its
+ * body fields, holding the host time at which it should appear. The frame
+ * is converted as usual but only flipped in at the refresh boundary nearest
+ * that time; a late frame is shown at the next boundary. Without a clock,
+ * or with a time more than PTS_MAX_AHEAD_US ahead, the PTS is ignored.
+ * Hosts re-send PKT_CLOCK every second or so to follow clock drift; every
+ * controller of a wall synced to one host clock flips together.
+ *
+ * Compression: a frame packet with PKT_FLAG_RLE carries its pixel data
+ * run-length coded, in units of one pixel (one byte for P4, two pixels).
+ * Each run starts with a control byte c: c < 0x80 is followed by c + 1
+ * literal units, c >= 0x80 by one unit repeated c - 0x7E times (2-129).
+ * Runs may cross rows of the rectangle but not its end; the one pad byte
+ * allowed after a packet is ignored once the rectangle is full.
+ *
+ * Clips (firmware built with HUB75_USE_CLIPS): a clip is a recorded stream
+ * of display packets (FULL/ROWS/RECT, legacy, PALETTE, DEPTH, BRIGHTNESS,
+ * LUT, drawing and SPRITE), COBS-encoded and delimited exactly as on the wire, kept in a flash
+ * slot. The host writes it with PKT_CLIP_DATA in CLIP_PAGE_SIZE pages, in
+ * order from page 0 (which starts a new upload and invalidates the slot),
+ * then PKT_CLIP_SAVE records its length and frame interval; the stream
+ * must end with a delimiter. PKT_CLIP_PLAY loops a saved clip from flash,
+ * one frame packet per interval, until it gets CLIP_STOP, another clip is
+ * uploaded or the host sends a frame packet. A clip should start with a
+ * PKT_FRAME_FULL so every loop restarts from a known frame. Flash writes
+ * blank the panel for a moment (up to one sector erase per page).
+ *
+ * Drawing: PKT_DRAW_FILL, PKT_DRAW_BLIT, PKT_DRAW_SCROLL and PKT_DRAW_TEXT
+ * are executed by the firmware on the frame it holds, which then re-planes
+ * only the rows they touched. They count as frame packets (credits, PTS,
+ * clip pacing) but never carry pixel data, so a ticker or a moving sprite
+ * costs a few bytes per frame. Unlike FRAME_RECT they take display
+ * coordinates (x from the left as seen, y from the top); the firmware
+ * mirrors them into the frame. Colours are pixel values in the packet's
+ * format, which must be the current one, except for a fill covering the
+ * whole display, which switches to it. BLIT and TEXT clip at the display
+ * edges; FILL and SCROLL rectangles must lie inside it. SCROLL moves a
+ * rectangle's content dx pixels right and dy down, wrapping around inside
+ * it. TEXT draws ASCII 0x20-0x7E in the built-in 5x7 font on a 6x8 cell
+ * grid (other bytes draw '?'), over the cells' background with
+ * TEXT_FLAG_BACKGROUND.
+ *
+ * Sprites: PKT_SPRITE stores a width x height block of pixels (frame
+ * layout, like a FRAME_RECT body, RLE allowed) in one of SPRITE_SLOTS RAM
+ * slots of SPRITE_BYTES each; PKT_DRAW_BLIT copies it into the frame, which
+ * must be in the sprite's format, leaving pixels equal to the key colour
+ * untouched with BLIT_FLAG_KEY. A rejected upload empties its slot.
+ *
+ * Statistics: a PKT_STATS from the host (no body) is answered with a
+ * PKT_STATS carrying pkt_stats_t, on the interface it came in on. Counts
+ * and cycle totals wrap at 32 bits and are never reset, so hosts take
+ * rates from the difference between two replies; only convert_max_cycles
+ * restarts with each query. Cycles are clk_sys cycles (clk_mhz per us).
+ */
+
+#ifndef HUB75_PROTOCOL_H
+#define HUB75_PROTOCOL_H
+
+#include <stdint.h>
+
+#define PROTO_MAGIC         0xA5
+#define PROTO_VERSION       1
+
+// ============================================
+// Packet types
+// ============================================
+#define PKT_FRAME_FULL      0x01    // Body: full RGB565 frame
+#define PKT_FRAME_ROWS      0x02    // Body: pkt_rows_t + height rows of pixels
+#define PKT_FRAME_RECT      0x03    // Body: pkt_rect_t + w*h pixels
+#define PKT_PALETTE         0x04    // Body: pkt_palette_t + count RGB888 entries
+#define PKT_DEPTH           0x05    // Body: pkt_depth_t
+#define PKT_BRIGHTNESS      0x06    // Body: pkt_brightness_t
+#define PKT_LUT             0x07    // Body: pkt_lut_t + u16 levels (32/64/32)
+#define PKT_CREDIT          0x08    // Body: pkt_credit_t (both directions)
+#define PKT_CLOCK           0x09    // Body: pkt_clock_t
+#define PKT_CLIP_DATA       0x0A    // Body: pkt_clip_data_t + CLIP_PAGE_SIZE bytes
+#define PKT_CLIP_SAVE       0x0B    // Body: pkt_clip_save_t
+#define PKT_CLIP_PLAY       0x0C    // Body: pkt_clip_play_t
+#define PKT_STATS           0x0D    // Body: none (query) / pkt_stats_t (reply)
+#define PKT_DRAW_FILL       0x0E    // Body: pkt_fill_t
+#define PKT_SPRITE          0x0F    // Body: pkt_sprite_t + w*h pixels
+#define PKT_DRAW_BLIT       0x10    // Body: pkt_blit_t
+#define PKT_DRAW_SCROLL     0x11    // Body: pkt_scroll_t
+#define PKT_DRAW_TEXT       0x12    // Body: pkt_text_t + length characters
+
+// ============================================
+// Pixel formats (pkt_header_t.flags & PKT_FORMAT_MASK)
+// ============================================
+#define PKT_FORMAT_MASK     0x07
+#define PIXFMT_RGB565       0       // 16 bpp
+#define PIXFMT_RGB332       1       // 8 bpp, RRRGGGBB
+#define PIXFMT_P8           2       // 8 bpp palette index
+#define PIXFMT_P4           3       // 4 bpp palette index (entries 0-15)
+
+// Frame and drawing packets only: a pkt_pts_t follows the header
+#define PKT_FLAG_PTS        0x08
+// Frame and sprite packets only: pixel data is run-length coded
+#define PKT_FLAG_RLE        0x10
+
+// ============================================
+// Packet layouts
+// ============================================
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;     // PROTO_MAGIC
+    uint8_t  version;   // PROTO_VERSION
+    uint8_t  type;      // PKT_*
+    uint8_t  flags;     // Bits 0-2: pixel format (PIXFMT_*), bits 3-4: PKT_FLAG_*
+} pkt_header_t;
+
+// Row range update: rows [y, y + height)
+typedef struct __attribute__((packed)) {
+    uint16_t y;
+    uint16_t height;
+} pkt_rows_t;
+
+// Rectangle update: pixels [x, x + width) x [y, y + height)
+typedef struct __attribute__((packed)) {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+} pkt_rect_t;
+
+// Palette update: entries [first, first + count), 3 bytes (R, G, B) each
+typedef struct __attribute__((packed)) {
+    uint16_t first;
+    uint16_t count;
+} pkt_palette_t;
+
+// BCM colour depth in bits per channel
+typedef struct __attribute__((packed)) {
+    uint8_t  depth;
+} pkt_depth_t;
+
+// Global brightness, OE on-time scale out of 255
+typedef struct __attribute__((packed)) {
+    uint8_t  level;
+} pkt_brightness_t;
+
+// Channel curve for RGB565 frames: 0 = R (32 entries), 1 = G (64), 2 = B (32)
+typedef struct __attribute__((packed)) {
+    uint8_t  channel;
+} pkt_lut_t;
+
+// Presentation time of a frame, host clock in microseconds
+typedef struct __attribute__((packed)) {
+    uint32_t time_us;
+} pkt_pts_t;
+
+// Host clock in microseconds when the packet was sent
+typedef struct __attribute__((packed)) {
+    uint32_t time_us;
+} pkt_clock_t;
+
+// Flow control: frame packets consumed (wrapping) and frame window
+typedef struct __attribute__((packed)) {
+    uint16_t frames;
+    uint8_t  window;
+} pkt_credit_t;
+
+// Performance counters (reply to PKT_STATS)
+typedef struct __attribute__((packed)) {
+    uint32_t time_us;               // Device clock
+    uint32_t rx_bytes;              // Bytes received from the host
+    uint32_t packets;               // Host packets accepted (not clip playback)
+    uint32_t dropped;               // Rejected: bad header, fields or size
+    uint32_t cobs_errors;           // Cut short by a delimiter mid COBS block
+    uint32_t frames;                // Frames converted and published
+    uint32_t flips;                 // Frames switched in by the refresh
+    uint32_t sweeps;                // Refresh sweeps (every plane of every row)
+    uint32_t decode_cycles;         // Core0 in the packet decoder
+    uint32_t convert_cycles;        // Core0 converting to bit planes
+    uint32_t convert_max_cycles;    // Longest single frame since the last query
+    uint32_t idle_cycles;           // Core1 waiting on DMA, PIO or on-time
+    uint16_t clk_mhz;               // clk_sys
+    uint8_t  depth;                 // Active colour depth
+    uint8_t  queued;                // Frames waiting for conversion
+} pkt_stats_t;
+
+// ============================================
+// Drawing
+// ============================================
+#define BLIT_FLAG_KEY           0x01    // pkt_blit_t.flags: skip key-coloured pixels
+#define TEXT_FLAG_BACKGROUND    0x01    // pkt_text_t.flags: fill the cells first
+
+// Font cell (glyphs are 5x7 at its top left)
+#define FONT_CELL_WIDTH     6
+#define FONT_CELL_HEIGHT    8
+
+// Solid rectangle [x, x + width) x [y, y + height)
+typedef struct __attribute__((packed)) {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    uint16_t color;
+} pkt_fill_t;
+
+// Sprite upload: width x height pixels in the header's format follow
+typedef struct __attribute__((packed)) {
+    uint8_t  slot;      // 0 to SPRITE_SLOTS - 1
+    uint8_t  reserved;
+    uint16_t width;
+    uint16_t height;
+} pkt_sprite_t;
+
+// Sprite copy with its top left at (x, y), which may be off the display
+typedef struct __attribute__((packed)) {
+    uint8_t  slot;
+    uint8_t  flags;     // BLIT_FLAG_*
+    int16_t  x;
+    int16_t  y;
+    uint16_t key;       // Transparent colour with BLIT_FLAG_KEY
+} pkt_blit_t;
+
+// Rotate the content of [x, x + width) x [y, y + height) by (dx, dy)
+typedef struct __attribute__((packed)) {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    int16_t  dx;        // Pixels right (negative: left)
+    int16_t  dy;        // Pixels down (negative: up)
+} pkt_scroll_t;
+
+// Text with the first cell's top left at (x, y)
+typedef struct __attribute__((packed)) {
+    int16_t  x;
+    int16_t  y;
+    uint16_t color;
+    uint16_t background;    // With TEXT_FLAG_BACKGROUND
+    uint8_t  flags;         // TEXT_FLAG_*
+    uint8_t  length;        // Characters that follow, 1-255
+} pkt_text_t;
+
+// ============================================
+// Clips (flash)
+// ============================================
+#define CLIP_PAGE_SIZE      256     // Stream bytes per PKT_CLIP_DATA (flash page)
+#define CLIP_STOP           0xFF    // pkt_clip_play_t.clip: stop playback
+#define CLIP_FLAG_AUTOPLAY  0x01    // pkt_clip_save_t.flags: play at boot
+
+// One page of the clip stream: bytes [page * CLIP_PAGE_SIZE, +CLIP_PAGE_SIZE)
+typedef struct __attribute__((packed)) {
+    uint8_t  clip;      // Slot, 0 to CLIP_SLOTS - 1
+    uint8_t  reserved;
+    uint16_t page;
+} pkt_clip_data_t;
+
+// Finish an upload: stream length in bytes and time per frame packet
+typedef struct __attribute__((packed)) {
+    uint8_t  clip;
+    uint8_t  flags;     // CLIP_FLAG_*
+    uint16_t interval_ms;
+    uint32_t length;
+} pkt_clip_save_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  clip;      // Slot, or CLIP_STOP
+} pkt_clip_play_t;
+
+#endif // HUB75_PROTOCOL_H
@@ -74,7 +74,19 @@ extern "C" {
 #define CFG_TUD_MSC             0
 #define CFG_TUD_HID             0
 #define CFG_TUD_MIDI            0
-#define CFG_TUD_VENDOR          0
+
+// Vendor (WebUSB bulk) interface, enabled with -D HUB75_USE_VENDOR=1
+#ifndef HUB75_USE_VENDOR
+#define HUB75_USE_VENDOR        0
+#endif
+#define CFG_TUD_VENDOR          HUB75_USE_VENDOR
+
+#if CFG_TUD_VENDOR
+// Same software FIFO sizing as CDC RX: one full 128x64 frame
+#define CFG_TUD_VENDOR_EPSIZE       64
+#define CFG_TUD_VENDOR_RX_BUFSIZE   16384
+#define CFG_TUD_VENDOR_TX_BUFSIZE   256
+#endif
 
 //--------------------------------------------------------------------
 // MEMORY CONFIGURATION
@@ -2,200 +2,2164 @@
  * HUB75 LED Panel Controller for RP2040
  * PlatformIO / Arduino (Earle Philhower core)
  *
- * Core0: USB CDC receive (Base64 encoded RGB565) + BCM conversion
+ * Core0: USB CDC receive (streaming COBS decode, see hub75_protocol.h) + BCM
+ *        conversion, interleaved by scan-row band (ring of frame slots)
  * Core1: HUB75 panel refresh ONLY (no other operations for flicker-free display)
  *
+ * BCM planes are double-buffered: Core0 converts into the back buffer and
+ * Core1 swaps it in only after a complete bitplane sweep (no tearing).
+ *
  * Build options (platformio.ini):
  *   -D HUB75_USE_PIO=1  : Use PIO for high-speed shifting (default)
  *   -D HUB75_USE_PIO=0  : Use CPU GPIO bit-banging
+ *   -D HUB75_USE_DMA_CHAIN=1 : PIO + DMA control-block chain, refresh runs
+ *                              without CPU (Core1 only re-arms once per frame)
+ *   -D HUB75_PACKED_PLANES=1 : PIO-ready plane rows, DMA reads them directly
+ *                              (no prepare_dma_buffer copy; implied by DMA chain)
+ *   -D HUB75_BENCHMARK=1     : Print convert_to_bcm cycle counts at boot
+ *   -D HUB75_SELFTEST=1      : Show a shift test pattern at boot and print
+ *                              the clock profile's refresh rate per depth
+ *   -D HUB75_USE_VENDOR=1    : Also accept packets on a WebUSB vendor (bulk)
+ *                              interface, same COBS stream as CDC
+ *   -D HUB75_USE_CLIPS=1     : Store uploaded clips in flash and play them
+ *                              back locally (PKT_CLIP_*)
+ *   -D HUB75_DITHER_BITS=n   : Temporal dithering, 2^n plane sets shown in
+ *                              turn for n (1-2) extra bits of perceived depth
+ *                              (2^n x plane RAM and conversion time)
+ *
+ * BCM on-times are counted in clk_sys cycles (BCM_LSB_CYCLES): by a PIO
+ * state machine driving OE in the PIO modes, by SysTick in GPIO mode. The
+ * next row is shifted in while the current one is lit (pipelined latch).
  *
- * Pin connections:
+ * Pin connections (HUB75_CHAINS=1, see hub75_config.h for 2/3 chains):
  *   GP0-5:   R0,G0,B0,R1,G1,B1 (RGB data)
  *   GP6:     CLK (clock)
  *   GP7:     LAT (latch)
  *   GP8:     OE  (output enable, active LOW)
- *   GP9-12:  A,B,C,D (row address)
+ *   GP9-13:  A,B,C,D,E (row address, as many as the scan needs)
  */
 
 #include <Arduino.h>
 #include <hardware/gpio.h>
+#include <hardware/clocks.h>
+#include <hardware/timer.h>
 #include <hardware/structs/sio.h>
+#include <hardware/structs/systick.h>
 
 // Default to PIO mode if not specified
 #ifndef HUB75_USE_PIO
 #define HUB75_USE_PIO 1
 #endif
 
+// DMA-chained refresh (PIO only), off by default
+#ifndef HUB75_USE_DMA_CHAIN
+#define HUB75_USE_DMA_CHAIN 0
+#endif
+
+#if HUB75_USE_DMA_CHAIN && !HUB75_USE_PIO
+#error "HUB75_USE_DMA_CHAIN requires HUB75_USE_PIO=1"
+#endif
+
+// Packed planes: rows stored in shift order, 4 pixels per 32-bit DMA word
+#ifndef HUB75_PACKED_PLANES
+#define HUB75_PACKED_PLANES HUB75_USE_DMA_CHAIN
+#endif
+
+// Boot-time convert_to_bcm benchmark, off by default
+#ifndef HUB75_BENCHMARK
+#define HUB75_BENCHMARK 0
+#endif
+
+// Boot-time clock profile self-test (refresh rate), off by default
+#ifndef HUB75_SELFTEST
+#define HUB75_SELFTEST 0
+#endif
+
+// WebUSB vendor-class bulk transport next to CDC, off by default
+#ifndef HUB75_USE_VENDOR
+#define HUB75_USE_VENDOR 0
+#endif
+
+#if HUB75_USE_VENDOR && !USE_TINYUSB
+#error "HUB75_USE_VENDOR requires USE_TINYUSB=1"
+#endif
+
+// Flash clip cache, off by default (needs board_build.filesystem_size)
+#ifndef HUB75_USE_CLIPS
+#define HUB75_USE_CLIPS 0
+#endif
+
+// Temporal dithering (extra bits of perceived depth), off by default. Every
+// frame converts all 2^n phase sets, so Core0 conversion takes 2^n times as
+// long (the sustained frame rate of a stream drops accordingly), and plane
+// RAM grows 2^n times (checked against RAM_BUFFERS_MAX below).
+#ifndef HUB75_DITHER_BITS
+#define HUB75_DITHER_BITS 0
+#endif
+
+#if HUB75_DITHER_BITS < 0 || HUB75_DITHER_BITS > 2
+#error "HUB75_DITHER_BITS must be 0, 1 or 2"
+#endif
+
+#if HUB75_PACKED_PLANES && !HUB75_USE_PIO
+#error "HUB75_PACKED_PLANES requires HUB75_USE_PIO=1"
+#endif
+
+#if HUB75_USE_DMA_CHAIN && !HUB75_PACKED_PLANES
+#error "HUB75_USE_DMA_CHAIN reads plane rows directly and needs HUB75_PACKED_PLANES=1"
+#endif
+
 #if HUB75_USE_PIO
 #include <hardware/pio.h>
 #include <hardware/dma.h>
 #include "hub75.pio.h"
 #endif
 
+#if HUB75_USE_DMA_CHAIN
+#include <hardware/irq.h>
+#endif
+
+#if HUB75_USE_CLIPS
+#include <hardware/flash.h>
+#endif
+
 #if USE_TINYUSB
 #include <Adafruit_TinyUSB.h>
 #endif
 #include "hub75_config.h"
+#include "hub75_protocol.h"
+#include "hub75_font.h"
+
+#if COLOR_DEPTH != 4 && COLOR_DEPTH != 6 && COLOR_DEPTH != 8 && COLOR_DEPTH != 10
+#error "COLOR_DEPTH must be 4, 6, 8 or 10"
+#endif
+
+#if SCAN_ROWS != 4 && SCAN_ROWS != 8 && SCAN_ROWS != 16 && SCAN_ROWS != 32
+#error "SCAN_ROWS must be 4, 8, 16 or 32 (1/4 to 1/32 scan)"
+#endif
+
+#if HUB75_CHAINS < 1 || HUB75_CHAINS > 3
+#error "HUB75_CHAINS must be 1, 2 or 3"
+#endif
+
+#if PANEL_ROTATION % 180 == 0
+#if DISPLAY_WIDTH != PANEL_COLS * PANEL_WIDTH || \
+    DISPLAY_HEIGHT != HUB75_CHAINS * PANEL_ROWS * PANEL_HEIGHT
+#error "DISPLAY_WIDTH/HEIGHT must match the panel grid (PANEL_COLS/ROWS x PANEL_WIDTH/HEIGHT per chain)"
+#endif
+#elif DISPLAY_WIDTH != HUB75_CHAINS * PANEL_ROWS * PANEL_HEIGHT || \
+    DISPLAY_HEIGHT != PANEL_COLS * PANEL_WIDTH
+#error "DISPLAY_WIDTH/HEIGHT must match the rotated panel grid"
+#endif
+
+#if (PANEL_HEIGHT / 2) % SCAN_ROWS != 0 || PANEL_WIDTH % PANEL_SCAN_CHUNK != 0
+#error "PANEL_HEIGHT / 2 must be a multiple of SCAN_ROWS, PANEL_WIDTH of PANEL_SCAN_CHUNK"
+#endif
+
+#if DISPLAY_WIDTH * DISPLAY_HEIGHT > 65536
+#error "bcm_map holds 16-bit pixel indices: at most 65536 pixels"
+#endif
+
+#if SHIFT_WIDTH % 4 != 0
+#error "Pixels per shift row (SHIFT_WIDTH) must be a multiple of 4"
+#endif
+
+#if PIN_ADDR_A + N_ADDR_PINS > 23 && PIN_ADDR_A < 23
+#error "Row address pins run past GP22 (not consecutive on a Pico)"
+#endif
+
+#if HUB75_USE_DMA_CHAIN && (PIN_OE != PIN_LAT + 1)
+#error "DMA-chained refresh drives LAT/OE by side-set: PIN_OE must be PIN_LAT + 1"
+#endif
 
 // GPIO masks for fast register access
-#define RGB_MASK    ((1 << PIN_R0) | (1 << PIN_G0) | (1 << PIN_B0) | \
-                     (1 << PIN_R1) | (1 << PIN_G1) | (1 << PIN_B1))
+#define RGB_MASK    (((1u << RGB_PINS) - 1) << PIN_R0)
 #define CLK_MASK    (1 << PIN_CLK)
 #define LAT_MASK    (1 << PIN_LAT)
 #define OE_MASK     (1 << PIN_OE)
-#define ADDR_MASK   ((1 << PIN_ADDR_A) | (1 << PIN_ADDR_B) | \
-                     (1 << PIN_ADDR_C) | (1 << PIN_ADDR_D))
+#define ADDR_MASK   (((1 << N_ADDR_PINS) - 1) << PIN_ADDR_A)
+
+// ============================================
+// Frame Buffers
+// ============================================
+// Ring of frame slots (FRAME_SLOTS): frame_buffer is the one packets are
+// decoded into, the others hold frames queued for conversion
+static uint16_t frame_slots[FRAME_SLOTS][DISPLAY_WIDTH * DISPLAY_HEIGHT];
+static uint16_t* frame_buffer = frame_slots[0];
+static volatile bool frame_ready = false;
+
+// BCM bit planes: [buffer][row][bit][shift column] = packed 6-bit RGB per
+// chain, chain n in bits 6n-6n+5 (one RGB_PINS-wide PIO output)
+// Core0 converts into the back buffer while Core1 displays the front one
+#if SHIFT_PIXEL_BITS == 8
+typedef uint8_t bcm_px_t;
+#elif SHIFT_PIXEL_BITS == 16
+typedef uint16_t bcm_px_t;
+#else
+typedef uint32_t bcm_px_t;
+#endif
+typedef bcm_px_t bcm_row_t[COLOR_DEPTH][SHIFT_WIDTH];
+
+// Temporal dithering: each buffer holds BCM_PHASES plane sets, converted
+// from the level at HUB75_DITHER_BITS more bits with the dropped fraction
+// spread over the phases. Core1 shows them in turn, one per sweep, so the
+// average over BCM_PHASES sweeps carries the extra bits while every sweep
+// still costs bcm_depth planes.
+#define BCM_PHASES      (1 << HUB75_DITHER_BITS)
+typedef bcm_row_t bcm_plane_set_t[SCAN_ROWS];
+// 12KB/24KB per plane set at 6-bit
+static bcm_plane_set_t bcm_planes[2][BCM_PHASES] __attribute__((aligned(4)));
+
+#define BCM_PLANE_SET_BYTES (SCAN_ROWS * COLOR_DEPTH * SHIFT_WIDTH * SHIFT_PIXEL_BITS / 8)
+static_assert(sizeof(bcm_plane_set_t) == BCM_PLANE_SET_BYTES, "BCM_PLANE_SET_BYTES");
+
+#if 2 * BCM_PHASES * BCM_PLANE_SET_BYTES + FRAME_SLOTS * FRAME_SIZE_RGB565 + \
+    SPRITE_SLOTS * SPRITE_BYTES > RAM_BUFFERS_MAX
+#error "BCM planes, frame slots and sprites exceed RAM_BUFFERS_MAX (lower HUB75_DITHER_BITS or COLOR_DEPTH)"
+#endif
+
+// 32-bit DMA words per plane row
+#define SHIFT_ROW_WORDS (SHIFT_WIDTH * SHIFT_PIXEL_BITS / 32)
+static volatile uint8_t bcm_front = 0;           // Buffer shown by Core1
+static volatile bool bcm_swap_pending = false;   // Back buffer ready to show
+
+// Presentation time of the pending back buffer (device microseconds), and
+// what Core0 will attach to the next one it publishes
+static volatile bool bcm_present_timed = false;
+static volatile uint32_t bcm_present_at = 0;
+static bool bcm_next_timed = false;
+static uint32_t bcm_next_at = 0;
+
+// Core1: start and length of the last full sweep
+static uint32_t bcm_sweep_start = 0;
+static uint32_t bcm_sweep_us = 0;
+
+// Core1 counters (PKT_STATS): frames flipped in, sweeps, and SysTick cycles
+// spent waiting on DMA, PIO or the on-time
+static volatile uint32_t stats_flips = 0;
+static volatile uint32_t stats_sweeps = 0;
+static volatile uint32_t stats_idle_cycles = 0;
+
+// Runtime color depth: what Core0 converts at, and what each buffer holds
+// (Core1 refreshes a buffer with its own depth, so a switch never tears)
+static uint8_t bcm_depth = COLOR_DEPTH;
+static volatile uint8_t bcm_buf_depth[2] = {COLOR_DEPTH, COLOR_DEPTH};
+
+// Instantiate fn<depth> for each runtime depth. Depths above COLOR_DEPTH
+// are rejected on input; capping them keeps those cases from instantiating.
+#define BCM_DEPTH_CAP(d)    ((d) < COLOR_DEPTH ? (d) : COLOR_DEPTH)
+#define BCM_DISPATCH_DEPTH(depth, fn, ...)                      \
+    switch (depth) {                                            \
+    case 4:  fn<BCM_DEPTH_CAP(4)>(__VA_ARGS__); break;          \
+    case 6:  fn<BCM_DEPTH_CAP(6)>(__VA_ARGS__); break;          \
+    case 8:  fn<BCM_DEPTH_CAP(8)>(__VA_ARGS__); break;          \
+    default: fn<BCM_DEPTH_CAP(10)>(__VA_ARGS__); break;         \
+    }
+
+// LSB on-time in clk_sys cycles (BCM_LSB_CYCLES, resolved at init)
+static uint32_t bcm_lsb_cycles = 0;
+
+// Global brightness (PKT_BRIGHTNESS) scales each plane's OE on-time, so
+// dimming keeps the full depth and needs no reconversion
+static uint8_t bcm_brightness = 255;
+static volatile uint32_t bcm_plane_cycles[COLOR_DEPTH];
+
+// Panel mapping: frame_buffer pixel index of the upper / lower half pixel
+// of each chain ([2n] / [2n + 1]) at every shift column of every scan row,
+// and the scan rows each frame row is shown on (built once by init_panel_map)
+#define BCM_MAP_PIXELS  (2 * HUB75_CHAINS)
+static uint16_t bcm_map[SCAN_ROWS][SHIFT_WIDTH][BCM_MAP_PIXELS];
+static uint32_t bcm_row_scan_mask[DISPLAY_HEIGHT];
+
+// Scan rows (bit mask) a buffer is missing relative to frame_buffer (Core0 only)
+#define BCM_ALL_ROWS    ((uint32_t)((1ull << SCAN_ROWS) - 1))
+static uint32_t bcm_stale[2] = {0, 0};
+
+// Packed plane rows are stored in shift order: element 0 is shifted first
+#if HUB75_PACKED_PLANES
+#define BCM_COLUMN(x)   (SHIFT_WIDTH - 1 - (x))
+#else
+#define BCM_COLUMN(x)   (x)
+#endif
+
+// Frame rows written by rejected packets, folded into the next conversion
+static uint32_t frame_dirty = 0;
+
+// Pixel format frame_buffer currently holds (PIXFMT_*). 8/4-bit formats use
+// the start of frame_buffer as a byte array with the same row-major layout.
+static uint8_t frame_format = PIXFMT_RGB565;
+
+// Uploaded palette (RGB888), used by PIXFMT_P8 / PIXFMT_P4
+static uint8_t palette_rgb[256][3];
+
+// 8-bit input -> 16-bit linear level, reduced to the active depth on use
+static uint16_t gamma_tbl[256];
+
+// Per-channel RGB565 component -> 16-bit level curves (PKT_LUT), sampled
+// from gamma_tbl at boot. Indexed formats keep gamma_tbl for palette colours.
+#define LUT_ENTRIES_MAX 64
+static const uint8_t lut_entries[3] = {32, 64, 32};
+static uint16_t channel_lut[3][LUT_ENTRIES_MAX];
+
+// BCM spread tables: RGB565 channel value -> its bit in every plane byte.
+// Plane b lives in byte (b % 4) of word (b / 4); R/G/B use bits 0/1/2.
+// Lower-half pixels reuse the same tables shifted left by 3. Every dither
+// phase has its own set.
+#define BCM_LUT_WORDS   ((COLOR_DEPTH + 3) / 4)
+typedef struct { uint32_t w[BCM_LUT_WORDS]; } bcm_spread_t;
+static bcm_spread_t bcm_lut_r[BCM_PHASES][32];
+static bcm_spread_t bcm_lut_g[BCM_PHASES][64];
+static bcm_spread_t bcm_lut_b[BCM_PHASES][32];
+
+// Whole-pixel spread tables for indexed formats: one lookup per pixel
+static bcm_spread_t bcm_pal_rgb332[BCM_PHASES][256];   // Fixed RRRGGGBB palette
+static bcm_spread_t bcm_pal[BCM_PHASES][256];          // From palette_rgb
+
+// SysTick cycles since start (24-bit down-counter, set up on the core using it)
+static inline uint32_t systick_elapsed(uint32_t start) {
+    return (start - systick_hw->cvr) & 0x00FFFFFF;
+}
+
+// Per-core SysTick free-running at clk_sys (each core starts its own)
+static inline void systick_start() {
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;  // Enable, processor clock
+}
+
+// Boot screen complete flag
+static volatile bool boot_complete = false;
+
+#if HUB75_USE_PIO
+// PIO instance and state machine
+static PIO hub75_pio = pio0;
+static uint sm_data = 0;
+
+// DMA channel for PIO data transfer
+static int dma_chan = -1;
+
+#if HUB75_USE_DMA_CHAIN
+// Row/latch/OE state machine
+static uint sm_row = 1;
+
+// Control channel: loads the next plane row into dma_chan
+static int dma_ctrl_chan = -1;
+
+// Row channel: feeds hub75_row with one word per plane row
+static int dma_row_chan = -1;
+
+// One refresh step per (bit, row), bit-major like the CPU refresh loop
+#define CHAIN_STEPS     (COLOR_DEPTH * SCAN_ROWS)
+
+// Control blocks per BCM buffer and dither phase: plane row addresses,
+// NULL-terminated
+static const bcm_px_t* chain_blocks[2][BCM_PHASES][CHAIN_STEPS + 1];
+
+// hub75_row words per BCM buffer: [31:5] OE on-time cycles - 2, [4:0] row address
+static uint32_t row_words[2][CHAIN_STEPS];
+
+// Sized for COLOR_DEPTH; a buffer at a lower depth uses the first steps
+static void hub75_chain_build(int buf);
+static void hub75_chain_blank();
+#else
+// OE state machine: times each row's on-time
+static uint sm_oe = 1;
+#endif
+
+#if !HUB75_USE_DMA_CHAIN && !HUB75_PACKED_PLANES
+// Double buffer for DMA (ping-pong)
+// Each pixel is expanded from 8-bit to 32-bit for PIO FIFO
+static uint32_t dma_buffer[2][SHIFT_WIDTH];
+#endif
+#endif
+
+// ============================================
+// Initialize gamma table
+// ============================================
+void init_gamma(float gamma_val) {
+    for (int i = 0; i < 256; i++) {
+        float norm = (float)i / 255.0f;
+        gamma_tbl[i] = (uint16_t)(powf(norm, gamma_val) * 65535.0f + 0.5f);
+    }
+}
+
+// ============================================
+// Build BCM spread tables from gamma table / channel curves
+// ============================================
+// OR one 16-bit level, reduced to bcm_depth, into a spread entry. With
+// dithering the level keeps HUB75_DITHER_BITS more bits, and phases below
+// that fraction show one LSB more (all BCM_PHASES phases average to it).
+static void spread_level(bcm_spread_t* out, uint16_t level16, int channel_bit, int phase) {
+    uint16_t fine = level16 >> (16 - bcm_depth - HUB75_DITHER_BITS);
+    uint16_t level = fine >> HUB75_DITHER_BITS;
+    if (phase < (fine & (BCM_PHASES - 1)) && level < (1u << bcm_depth) - 1) {
+        level++;
+    }
+    for (int bit = 0; bit < bcm_depth; bit++) {
+        if (level & (1 << bit)) {
+            out->w[bit / 4] |= 1u << (8 * (bit % 4) + channel_bit);
+        }
+    }
+}
+
+// RGB565 spread table of one channel (0 = R, 1 = G, 2 = B) from its curve
+static void spread_channel(int channel) {
+    for (int phase = 0; phase < BCM_PHASES; phase++) {
+        bcm_spread_t* const luts[3] = {bcm_lut_r[phase], bcm_lut_g[phase], bcm_lut_b[phase]};
+        bcm_spread_t* lut = luts[channel];
+        for (int v = 0; v < lut_entries[channel]; v++) {
+            memset(&lut[v], 0, sizeof(lut[v]));
+            spread_level(&lut[v], channel_lut[channel][v], channel, phase);
+        }
+    }
+}
+
+// Entry i of a whole-pixel table, in every phase
+static void spread_color(bcm_spread_t (*table)[256], int i, const uint8_t rgb[3]) {
+    for (int phase = 0; phase < BCM_PHASES; phase++) {
+        bcm_spread_t* e = &table[phase][i];
+        memset(e, 0, sizeof(*e));
+        spread_level(e, gamma_tbl[rgb[0]], 0, phase);
+        spread_level(e, gamma_tbl[rgb[1]], 1, phase);
+        spread_level(e, gamma_tbl[rgb[2]], 2, phase);
+    }
+}
+
+// Rebuild palette spread entries [first, first + count)
+static void update_palette_lut(int first, int count) {
+    for (int i = first; i < first + count; i++) {
+        spread_color(bcm_pal, i, palette_rgb[i]);
+    }
+}
+
+static void rgb332_color(int i, uint8_t rgb[3]) {
+    rgb[0] = ((i >> 5) & 0x07) * 255 / 7;
+    rgb[1] = ((i >> 2) & 0x07) * 255 / 7;
+    rgb[2] = (i & 0x03) * 85;
+}
 
+// All spread tables for bcm_depth
+static void build_bcm_lut() {
+    spread_channel(0);
+    spread_channel(1);
+    spread_channel(2);
+
+    uint8_t rgb[3];
+    for (int i = 0; i < 256; i++) {
+        rgb332_color(i, rgb);
+        spread_color(bcm_pal_rgb332, i, rgb);
+    }
+    update_palette_lut(0, 256);
+}
+
+void init_bcm_lut() {
+    // RGB332 is also the default upload palette
+    for (int i = 0; i < 256; i++) {
+        rgb332_color(i, palette_rgb[i]);
+    }
+
+    // Default curves: gamma_tbl at the RGB565 component values
+    for (int v = 0; v < 32; v++) {
+        channel_lut[0][v] = gamma_tbl[v << 3];
+        channel_lut[2][v] = gamma_tbl[v << 3];
+    }
+    for (int v = 0; v < 64; v++) {
+        channel_lut[1][v] = gamma_tbl[v << 2];
+    }
+    build_bcm_lut();
+}
+
+// Runtime depth switch (Core0). The caller reconverts the whole frame.
+static void set_bcm_depth(int depth) {
+    bcm_depth = depth;
+    build_bcm_lut();
+}
+
+// ============================================
+// Global brightness - OE on-time per plane
 // ============================================
-// COBS (Consistent Overhead Byte Stuffing) Decoder
+// On-times for a brightness level; Core1 picks them up at the next plane
+static void set_bcm_brightness(uint8_t level) {
+    bcm_brightness = level;
+    for (int bit = 0; bit < COLOR_DEPTH; bit++) {
+        bcm_plane_cycles[bit] = (uint32_t)(((uint64_t)bcm_lsb_cycles << bit) * level / 255);
+    }
+#if HUB75_USE_DMA_CHAIN
+    // Rewrites the front buffer's row words in place (see hub75_chain_build)
+    hub75_chain_build(0);
+    hub75_chain_build(1);
+    hub75_chain_blank();
+#endif
+}
+
+// ============================================
+// Panel mapping - shift position -> frame pixel
 // ============================================
-// Decodes COBS-encoded data back to original payload.
-// Returns decoded length, or 0 on error.
-// Max overhead: 1 byte per 254 bytes of data + 1 byte
-size_t cobs_decode(const uint8_t* input, size_t len, uint8_t* output, size_t max_output) {
-    if (len == 0) return 0;
+// Layout is in frame coordinates as sent by the host (mirrored, i.e. seen
+// from the back): chain panel 0 sits at grid column 0 of grid row 0, and
+// shift column 0 is the one nearest the controller. Parallel chains repeat
+// the grid below each other before rotation. Within a panel each
+// address drives SCAN_ROWS-spaced rows in both halves; below 1/(height/2)
+// scan those rows are shifted in alternating PANEL_SCAN_CHUNK-pixel blocks.
+void init_panel_map() {
+    const int groups = PANEL_HEIGHT / 2 / SCAN_ROWS;    // Rows per half per address
+    const int panel_shift = PANEL_WIDTH * groups;       // Shift columns per panel
+
+    memset(bcm_row_scan_mask, 0, sizeof(bcm_row_scan_mask));
 
-    size_t read_idx = 0;
-    size_t write_idx = 0;
+    for (int row = 0; row < SCAN_ROWS; row++) {
+        for (int col = 0; col < SHIFT_WIDTH; col++) {
+            int panel = col / panel_shift;
+            int c = col % panel_shift;
+
+            // Position inside the panel
+            int chunk = c / PANEL_SCAN_CHUNK;
+            int px = (chunk / groups) * PANEL_SCAN_CHUNK + c % PANEL_SCAN_CHUNK;
+            int py = (chunk % groups) * SCAN_ROWS + row;
+
+            // Panel position in the grid
+            int grid_row = panel / PANEL_COLS;
+            int grid_col = panel % PANEL_COLS;
+            bool flipped = PANEL_SERPENTINE && (grid_row & 1);
+            if (flipped) {
+                grid_col = PANEL_COLS - 1 - grid_col;
+            }
 
-    while (read_idx < len) {
-        uint8_t code = input[read_idx++];
+            for (int i = 0; i < BCM_MAP_PIXELS; i++) {
+                int chain = i / 2;
+                int half = i % 2;
+                int x = px;
+                int y = py + half * (PANEL_HEIGHT / 2);
+                if (flipped) {
+                    x = PANEL_WIDTH - 1 - x;
+                    y = PANEL_HEIGHT - 1 - y;
+                }
+                x += grid_col * PANEL_WIDTH;
+                y += (chain * PANEL_ROWS + grid_row) * PANEL_HEIGHT;
+
+                // Whole-display rotation (clockwise)
+                const int cw = PANEL_COLS * PANEL_WIDTH;
+                const int ch = HUB75_CHAINS * PANEL_ROWS * PANEL_HEIGHT;
+                int dx, dy;
+                switch (PANEL_ROTATION) {
+                case 90:  dx = ch - 1 - y; dy = x;          break;
+                case 180: dx = cw - 1 - x; dy = ch - 1 - y; break;
+                case 270: dx = y;          dy = cw - 1 - x; break;
+                default:  dx = x;          dy = y;          break;
+                }
+
+                bcm_map[row][col][i] = (uint16_t)(dy * DISPLAY_WIDTH + dx);
+                bcm_row_scan_mask[dy] |= 1u << row;
+            }
+        }
+    }
+}
+
+// ============================================
+// BCM buffer handoff (Core0 -> Core1)
+// ============================================
+// Core0 only ever writes the back buffer. Once a frame is complete it sets
+// bcm_swap_pending; Core1 flips bcm_front between full bitplane sweeps
+// and clears the flag, which hands the old front back to Core0. A timed
+// frame waits for the sweep boundary nearest its presentation time.
+
+// Wait until Core1 has taken the previously published frame
+static inline int bcm_acquire_back() {
+    while (bcm_swap_pending) {
+        tight_loop_contents();
+    }
+    __dmb();
+    return bcm_front ^ 1;
+}
+
+// Publish the back buffer; shown from the next sweep onward, or at its
+// presentation time (bcm_next_at) if one was set for it
+static inline void bcm_publish_back() {
+    bcm_present_timed = bcm_next_timed;
+    bcm_present_at = bcm_next_at;
+    bcm_next_timed = false;
+    __dmb();
+    bcm_swap_pending = true;
+}
+
+// Core1: flip now if this boundary is the one nearest the presentation time
+// (or that time has passed, or is implausibly far ahead)
+static inline bool __not_in_flash_func(bcm_present_due)(uint32_t now) {
+    if (!bcm_present_timed) {
+        return true;
+    }
+    int32_t ahead = (int32_t)(bcm_present_at - now);
+    return ahead <= (int32_t)(bcm_sweep_us / 2) || ahead > PTS_MAX_AHEAD_US;
+}
+
+// Called by Core1 between sweeps; returns the front buffer's phase sets
+static inline bcm_plane_set_t* __not_in_flash_func(bcm_take_front)() {
+    uint32_t now = time_us_32();
+    bcm_sweep_us = now - bcm_sweep_start;
+    bcm_sweep_start = now;
+    stats_sweeps++;
+
+    if (bcm_swap_pending && bcm_present_due(now)) {
+        bcm_front ^= 1;
+        __dmb();
+        bcm_swap_pending = false;
+        stats_flips++;
+    }
+    return bcm_planes[bcm_front];
+}
+
+// Core1: dither phase of the current sweep
+static uint8_t bcm_phase = 0;
+
+// Dither phase for the next sweep (always 0 without dithering)
+static inline int __not_in_flash_func(bcm_next_phase)() {
+    bcm_phase = (bcm_phase + 1) & (BCM_PHASES - 1);
+    return bcm_phase;
+}
+
+#if HUB75_BENCHMARK
+// ============================================
+// Reference BCM conversion (benchmark only)
+// ============================================
+// Original per-bit kernel, kept to measure and cross-check the LUT kernel
+static void convert_to_bcm_reference(const uint16_t* pixels, bcm_row_t* planes) {
+    for (int row = 0; row < SCAN_ROWS; row++) {
+        for (int x = 0; x < SHIFT_WIDTH; x++) {
+            for (int bit = 0; bit < bcm_depth; bit++) {
+                planes[row][bit][BCM_COLUMN(x)] = 0;
+            }
+
+            for (int chain = 0; chain < HUB75_CHAINS; chain++) {
+                uint16_t p_up = pixels[bcm_map[row][x][2 * chain]];
+                uint16_t p_lo = pixels[bcm_map[row][x][2 * chain + 1]];
+
+                // Extract and scale to 8-bit, then apply gamma
+                uint16_t r0 = gamma_tbl[((p_up >> 11) & 0x1F) << 3];
+                uint16_t g0 = gamma_tbl[((p_up >> 5) & 0x3F) << 2];
+                uint16_t b0 = gamma_tbl[(p_up & 0x1F) << 3];
+
+                uint16_t r1 = gamma_tbl[((p_lo >> 11) & 0x1F) << 3];
+                uint16_t g1 = gamma_tbl[((p_lo >> 5) & 0x3F) << 2];
+                uint16_t b1 = gamma_tbl[(p_lo & 0x1F) << 3];
+
+                // Scale 16-bit to the active depth
+                r0 >>= (16 - bcm_depth);
+                g0 >>= (16 - bcm_depth);
+                b0 >>= (16 - bcm_depth);
+                r1 >>= (16 - bcm_depth);
+                g1 >>= (16 - bcm_depth);
+                b1 >>= (16 - bcm_depth);
+
+                // Pack into bit planes
+                for (int bit = 0; bit < bcm_depth; bit++) {
+                    uint16_t mask = 1 << bit;
+                    bcm_px_t packed = 0;
+                    if (r0 & mask) packed |= 0x01;
+                    if (g0 & mask) packed |= 0x02;
+                    if (b0 & mask) packed |= 0x04;
+                    if (r1 & mask) packed |= 0x08;
+                    if (g1 & mask) packed |= 0x10;
+                    if (b1 & mask) packed |= 0x20;
+                    planes[row][bit][BCM_COLUMN(x)] |= packed << (6 * chain);
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+// ============================================
+// Convert frame to BCM planes
+// ============================================
+// Table-driven: each pixel's spread words come from a pixel source policy,
+// so RGB565 costs 3 lookups per pixel and indexed formats 1. The plane
+// loop is specialized per color depth (fully unrolled). Pixels are visited
+// in shift order through bcm_map, so panel layout costs no per-pixel math.
+// Only scan rows in row_mask are re-planed, plus any rows the back buffer
+// missed while it was the front one.
+
+// RGB565: per-channel tables
+struct bcm_src_rgb565 {
+    const uint16_t* px;
+
+    template <int WORDS>
+    inline void spread(int phase, int i, uint32_t* v) const {
+        uint16_t p = px[i];
+        const bcm_spread_t& r = bcm_lut_r[phase][p >> 11];
+        const bcm_spread_t& g = bcm_lut_g[phase][(p >> 5) & 0x3F];
+        const bcm_spread_t& b = bcm_lut_b[phase][p & 0x1F];
+        for (int w = 0; w < WORDS; w++) {
+            v[w] = r.w[w] | g.w[w] | b.w[w];
+        }
+    }
+};
+
+// RGB332 / P8: one byte per pixel, whole-pixel table
+struct bcm_src_index8 {
+    const uint8_t* px;
+    const bcm_spread_t (*pal)[256];
+
+    template <int WORDS>
+    inline void spread(int phase, int i, uint32_t* v) const {
+        const bcm_spread_t& e = pal[phase][px[i]];
+        for (int w = 0; w < WORDS; w++) {
+            v[w] = e.w[w];
+        }
+    }
+};
+
+// P4: two pixels per byte, low nibble first
+struct bcm_src_index4 {
+    const uint8_t* px;
+    const bcm_spread_t (*pal)[256];
+
+    template <int WORDS>
+    inline void spread(int phase, int i, uint32_t* v) const {
+        uint8_t p = px[i >> 1];
+        const bcm_spread_t& e = pal[phase][(i & 1) ? (p >> 4) : (p & 0x0F)];
+        for (int w = 0; w < WORDS; w++) {
+            v[w] = e.w[w];
+        }
+    }
+};
+
+// Phase tables are staggered in a 2x2 pattern (a checkerboard with 2
+// phases), so neighbouring pixels of one level step up in different
+// sweeps and the panel as a whole does not flicker at the phase rate
+static inline int bcm_dither_phase(int phase, int row, int x) {
+    return (phase + (((x ^ row) & 1) | ((x & 1) << 1))) & (BCM_PHASES - 1);
+}
+
+template <int DEPTH, typename Source>
+static void __not_in_flash_func(convert_rows)(const Source& src, bcm_row_t* planes, uint32_t rows,
+                                              int phase) {
+    constexpr int WORDS = (DEPTH + 3) / 4;
+
+    for (int row = 0; row < SCAN_ROWS; row++) {
+        if (!(rows & (1u << row))) {
+            continue;
+        }
+
+        bcm_row_t& dst = planes[row];
+        const uint16_t (*map)[BCM_MAP_PIXELS] = bcm_map[row];
+
+        for (int x = 0; x < SHIFT_WIDTH; x++) {
+            // One byte per plane and chain: upper half in bits 0-2, lower in bits 3-5
+            uint32_t v[HUB75_CHAINS][WORDS];
+            int table = bcm_dither_phase(phase, row, x);
+            for (int chain = 0; chain < HUB75_CHAINS; chain++) {
+                uint32_t up[WORDS];
+                uint32_t lo[WORDS];
+                src.template spread<WORDS>(table, map[x][2 * chain], up);
+                src.template spread<WORDS>(table, map[x][2 * chain + 1], lo);
+                for (int w = 0; w < WORDS; w++) {
+                    v[chain][w] = up[w] | (lo[w] << 3);
+                }
+            }
+
+            // Chain n's byte goes to bits 6n-6n+5 of the plane element
+            int col = BCM_COLUMN(x);
+            for (int w = 0; w < WORDS; w++) {
+                for (int i = 0; i < 4 && w * 4 + i < DEPTH; i++) {
+                    bcm_px_t e = 0;
+                    for (int chain = 0; chain < HUB75_CHAINS; chain++) {
+                        e |= (bcm_px_t)((v[chain][w] >> (8 * i)) & 0x3F) << (6 * chain);
+                    }
+                    dst[w * 4 + i][col] = e;
+                }
+            }
+        }
+    }
+}
+
+// Every dither phase of a buffer
+template <int DEPTH, typename Source>
+static void __not_in_flash_func(convert_phases)(const Source& src, bcm_plane_set_t* sets,
+                                                uint32_t rows) {
+    for (int phase = 0; phase < BCM_PHASES; phase++) {
+        convert_rows<DEPTH>(src, sets[phase], rows, phase);
+    }
+}
+
+// Scan rows of pixels (in format) into a buffer's phase sets
+static void __not_in_flash_func(convert_pixels_rows)(const uint16_t* pixels, uint8_t format,
+                                                     bcm_plane_set_t* sets, uint32_t rows) {
+    const uint8_t* bytes = (const uint8_t*)pixels;
+
+    switch (format) {
+    case PIXFMT_RGB332: {
+        bcm_src_index8 src = {bytes, bcm_pal_rgb332};
+        BCM_DISPATCH_DEPTH(bcm_depth, convert_phases, src, sets, rows);
+        break;
+    }
+    case PIXFMT_P8: {
+        bcm_src_index8 src = {bytes, bcm_pal};
+        BCM_DISPATCH_DEPTH(bcm_depth, convert_phases, src, sets, rows);
+        break;
+    }
+    case PIXFMT_P4: {
+        bcm_src_index4 src = {bytes, bcm_pal};
+        BCM_DISPATCH_DEPTH(bcm_depth, convert_phases, src, sets, rows);
+        break;
+    }
+    default: {
+        bcm_src_rgb565 src = {pixels};
+        BCM_DISPATCH_DEPTH(bcm_depth, convert_phases, src, sets, rows);
+        break;
+    }
+    }
+}
+
+// Back buffer fully converted (row_mask changed since the front one): publish it
+static void bcm_finish_back(int back, uint32_t row_mask) {
+    if (bcm_buf_depth[back] != bcm_depth) {
+        bcm_buf_depth[back] = bcm_depth;
+#if HUB75_USE_DMA_CHAIN
+        hub75_chain_build(back);
+#endif
+    }
+
+    // The buffer about to be retired lacks the rows just converted
+    bcm_stale[back] = 0;
+    bcm_stale[back ^ 1] |= row_mask;
+
+    bcm_publish_back();
+}
+
+// Whole conversion at once (boot / benchmark frames)
+static void convert_to_bcm_format(const uint16_t* pixels, uint8_t format, uint32_t row_mask) {
+    int back = bcm_acquire_back();
+    convert_pixels_rows(pixels, format, bcm_planes[back], row_mask | bcm_stale[back]);
+    bcm_finish_back(back, row_mask);
+}
+
+// RGB565 pixels
+void convert_to_bcm(const uint16_t* pixels, uint32_t row_mask) {
+    convert_to_bcm_format(pixels, PIXFMT_RGB565, row_mask);
+}
+
+// Bits per pixel of a pixel format, 0 if unknown
+static inline int pixfmt_bits(uint8_t format) {
+    switch (format) {
+    case PIXFMT_RGB565: return 16;
+    case PIXFMT_RGB332: return 8;
+    case PIXFMT_P8:     return 8;
+    case PIXFMT_P4:     return 4;
+    default:            return 0;
+    }
+}
+
+// ============================================
+// Frame slots - pipelined conversion (Core0)
+// ============================================
+// A completed update queues the receive slot, and decoding moves on to the
+// next slot, which starts as a copy so row and rectangle updates still
+// apply on top of it. loop() converts the oldest queued slot
+// CONVERT_BAND_ROWS scan rows at a time between USB chunks, so the FIFO
+// keeps draining while a frame converts and a sustained stream runs at
+// the slower of receive and convert rather than their sum. Receiving only
+// waits for a conversion once every slot is queued.
+struct frame_slot_t {
+    uint8_t format;     // PIXFMT_* the slot holds
+    uint8_t frames;     // Host frame packets this update completes (credits)
+    bool timed;         // Presentation time attached when published
+    uint32_t at;
+    uint32_t rows;      // Scan rows changed by the update
+};
+static frame_slot_t frame_slot_info[FRAME_SLOTS];
+static uint8_t rx_slot = 0;             // Slot frame_buffer points at
+static uint8_t conv_head = 0;           // Oldest queued slot
+static uint8_t conv_queued = 0;
+static int conv_back = -1;              // Back buffer of the head, -1 until it starts
+static uint32_t conv_left = 0;          // Scan rows of the head still to convert
+
+// Flow control (PKT_CREDIT): frame packets consumed, and whether the host
+// has yet to be told the current count (sent from loop())
+static uint16_t rx_frames_done = 0;
+static bool rx_credit_pending = false;
+
+// Core0 counters (PKT_STATS, see hub75_protocol.h), cycles by SysTick
+static uint32_t stats_rx_bytes = 0;
+static uint32_t stats_packets = 0;
+static uint32_t stats_dropped = 0;
+static uint32_t stats_cobs_errors = 0;
+static uint32_t stats_frames = 0;
+static uint32_t stats_decode_cycles = 0;
+static uint32_t stats_convert_cycles = 0;
+static uint32_t stats_convert_max = 0;
+static uint32_t conv_cycles = 0;        // Spent on the head so far
+
+// Convert up to band scan rows of the oldest queued slot; publishes it once
+// done. Returns without waiting while Core1 still owns the back buffer.
+static void __not_in_flash_func(convert_step)(int band) {
+    if (conv_queued == 0) {
+        return;
+    }
+    const frame_slot_t& slot = frame_slot_info[conv_head];
+
+    if (conv_back < 0) {
+        if (bcm_swap_pending) {
+            return;
+        }
+        conv_back = bcm_acquire_back();
+        conv_left = slot.rows | bcm_stale[conv_back];
+    }
+
+    // Lowest band rows still to convert
+    uint32_t rows = 0;
+    for (int i = 0; i < band && conv_left; i++) {
+        uint32_t row = conv_left & (0u - conv_left);
+        rows |= row;
+        conv_left &= ~row;
+    }
+    uint32_t start = systick_hw->cvr;
+    convert_pixels_rows(frame_slots[conv_head], slot.format, bcm_planes[conv_back], rows);
+    uint32_t cycles = systick_elapsed(start);
+    stats_convert_cycles += cycles;
+    conv_cycles += cycles;
+    if (conv_left) {
+        return;
+    }
 
-        if (code == 0) {
-            // Invalid: zero byte in encoded data
-            return 0;
+    bcm_next_timed = slot.timed;
+    bcm_next_at = slot.at;
+    bcm_finish_back(conv_back, slot.rows);
+    if (slot.frames) {
+        rx_frames_done += slot.frames;
+        rx_credit_pending = true;
+    }
+    stats_frames++;
+    if (conv_cycles > stats_convert_max) {
+        stats_convert_max = conv_cycles;
+    }
+    conv_cycles = 0;
+    conv_back = -1;
+    conv_head = (conv_head + 1) % FRAME_SLOTS;
+    conv_queued--;
+}
+
+// Convert (blocking) until at most keep slots are queued
+static void convert_drain(int keep) {
+    while (conv_queued > keep) {
+        convert_step(SCAN_ROWS);
+    }
+}
+
+// Queue frame_buffer (rows changed) for conversion and decode into the next slot
+static void frame_submit(uint32_t rows, bool timed, uint32_t at, uint8_t frames) {
+    frame_slot_info[rx_slot] = {frame_format, frames, timed, at, rows};
+    conv_queued++;
+
+    // Every slot queued: the next one is the oldest, free once it converts
+    if (conv_queued == FRAME_SLOTS) {
+        convert_drain(FRAME_SLOTS - 1);
+    }
+
+    uint8_t next = (rx_slot + 1) % FRAME_SLOTS;
+    if (next != rx_slot) {
+        memcpy(frame_slots[next], frame_slots[rx_slot],
+               sizeof(frame_slots[0]) * pixfmt_bits(frame_format) / 16);
+        rx_slot = next;
+        frame_buffer = frame_slots[next];
+    }
+}
+
+#if HUB75_USE_CLIPS
+// ============================================
+// Clip cache - packet streams in flash
+// ============================================
+// The filesystem region (board_build.filesystem_size) is split into
+// CLIP_SLOTS sector-aligned slots. Each starts with a clip_header_t page,
+// followed by the clip's COBS stream, which playback feeds to the packet
+// receiver straight from XIP.
+extern uint8_t _FS_start;
+extern uint8_t _FS_end;
+
+#define CLIP_MAGIC  0x50494C43u     // "CLIP"
+
+typedef struct {
+    uint32_t magic;         // CLIP_MAGIC once saved (erased flash: 0xFFFFFFFF)
+    uint32_t length;        // Stream bytes after the header page
+    uint16_t interval_ms;   // Time per frame packet
+    uint8_t  flags;         // CLIP_FLAG_*
+    uint8_t  reserved;
+} clip_header_t;
+
+// Upload in progress: slot and next page expected (-1: none)
+static int clip_upload_slot = -1;
+static uint32_t clip_upload_pages = 0;
+static uint8_t clip_page[CLIP_PAGE_SIZE] __attribute__((aligned(4)));
+
+// Playback: stream of the playing clip, next packet (nullptr when stopped)
+static const uint8_t* clip_begin = nullptr;
+static const uint8_t* clip_end = nullptr;
+static const uint8_t* clip_pos = nullptr;
+static uint32_t clip_interval_us = 0;
+static uint32_t clip_next_us = 0;
+
+static inline uint32_t clip_slot_size() {
+    return ((uint32_t)(&_FS_end - &_FS_start) / CLIP_SLOTS) & ~(FLASH_SECTOR_SIZE - 1);
+}
+
+static inline const uint8_t* clip_slot(int slot) {
+    return &_FS_start + slot * clip_slot_size();
+}
+
+// Header of a saved clip, or nullptr
+static const clip_header_t* clip_saved(uint8_t slot) {
+    if (slot >= CLIP_SLOTS || clip_slot_size() < 2 * CLIP_PAGE_SIZE) {
+        return nullptr;
+    }
+    const clip_header_t* hdr = (const clip_header_t*)clip_slot(slot);
+    if (hdr->magic != CLIP_MAGIC || hdr->interval_ms == 0 || hdr->length == 0 ||
+        hdr->length > clip_slot_size() - CLIP_PAGE_SIZE) {
+        return nullptr;
+    }
+    return hdr;
+}
+
+// Erase (the sector holding at) and/or program one page. Core1 is parked
+// while the flash is busy, since XIP is off. An erase takes tens of ms, and
+// the row lit when Core1 stopped (GPIO refresh) would stay on all that time,
+// so the panel is blanked (OE held high) until refresh resumes.
+static void clip_flash_write(const uint8_t* at, bool erase, const uint8_t* page) {
+    uint32_t offset = (uint32_t)(at - (const uint8_t*)XIP_BASE);
+    gpio_set_outover(PIN_OE, GPIO_OVERRIDE_HIGH);
+    noInterrupts();
+    rp2040.idleOtherCore();
+    if (erase) {
+        flash_range_erase(offset & ~(FLASH_SECTOR_SIZE - 1), FLASH_SECTOR_SIZE);
+    }
+    if (page) {
+        flash_range_program(offset, page, CLIP_PAGE_SIZE);
+    }
+    rp2040.resumeOtherCore();
+    interrupts();
+#if HUB75_USE_DMA_CHAIN
+    hub75_chain_blank();  // Stays blank at brightness 0
+#else
+    gpio_set_outover(PIN_OE, GPIO_OVERRIDE_NORMAL);
+#endif
+}
+
+static inline void clip_stop() {
+    clip_pos = nullptr;
+}
+
+// Pages arrive in order; page 0 restarts the upload of any slot
+static bool clip_page_valid(const pkt_clip_data_t& data) {
+    if (data.clip >= CLIP_SLOTS ||
+        (uint32_t)(data.page + 2) * CLIP_PAGE_SIZE > clip_slot_size()) {
+        return false;
+    }
+    return data.page == 0 ||
+           (data.clip == clip_upload_slot && data.page == clip_upload_pages);
+}
+
+// clip_page -> stream page. Each sector is erased as its first page is
+// written; page 0 shares sector 0 with the header, so the slot is invalid
+// until saved again.
+static void clip_write_page(const pkt_clip_data_t& data) {
+    clip_stop();  // May be the slot playing
+
+    uint32_t offset = (uint32_t)(data.page + 1) * CLIP_PAGE_SIZE;
+    bool erase = data.page == 0 || offset % FLASH_SECTOR_SIZE == 0;
+    clip_flash_write(clip_slot(data.clip) + offset, erase, clip_page);
+
+    clip_upload_slot = data.clip;
+    clip_upload_pages = data.page + 1;
+}
+
+// The written pages must cover the stream, which ends on a delimiter
+static bool clip_save_valid(const pkt_clip_save_t& save) {
+    if (save.clip != clip_upload_slot || save.interval_ms == 0 || save.length == 0 ||
+        save.length > clip_upload_pages * CLIP_PAGE_SIZE) {
+        return false;
+    }
+    return clip_slot(save.clip)[CLIP_PAGE_SIZE + save.length - 1] == 0x00;
+}
+
+static void clip_save(const pkt_clip_save_t& save) {
+    clip_header_t hdr = {CLIP_MAGIC, save.length, save.interval_ms, save.flags, 0};
+    memset(clip_page, 0xFF, sizeof(clip_page));
+    memcpy(clip_page, &hdr, sizeof(hdr));
+    clip_flash_write(clip_slot(save.clip), false, clip_page);
+    clip_upload_slot = -1;
+}
+
+// Start looping a saved clip (anything else stops playback)
+static void clip_play(uint8_t slot) {
+    const clip_header_t* hdr = clip_saved(slot);
+    if (!hdr) {
+        clip_stop();
+        return;
+    }
+    clip_begin = (const uint8_t*)hdr + CLIP_PAGE_SIZE;
+    clip_end = clip_begin + hdr->length;
+    clip_pos = clip_begin;
+    clip_interval_us = hdr->interval_ms * 1000u;
+    clip_next_us = time_us_32();
+}
+
+// Boot: play the first clip saved with CLIP_FLAG_AUTOPLAY
+static void clip_autoplay() {
+    for (int slot = 0; slot < CLIP_SLOTS; slot++) {
+        const clip_header_t* hdr = clip_saved(slot);
+        if (hdr && (hdr->flags & CLIP_FLAG_AUTOPLAY)) {
+            clip_play(slot);
+            return;
+        }
+    }
+}
+#endif
+
+// ============================================
+// Drawing commands (Core0)
+// ============================================
+// PKT_DRAW_* packets run on frame_buffer once they are complete and queue
+// only the scan rows they changed, so tickers, counters and moving sprites
+// convert a few rows instead of a frame. They give display x; frame rows
+// are mirrored, so display column x is frame column DISPLAY_WIDTH - 1 - x.
+
+// Scan rows driven by frame rows [y0, y1)
+static uint32_t scan_rows_mask(int y0, int y1) {
+    uint32_t mask = 0;
+    for (int y = y0; y < y1 && mask != BCM_ALL_ROWS; y++) {
+        mask |= bcm_row_scan_mask[y];
+    }
+    return mask;
+}
+
+// Sprite cache (PKT_SPRITE): pixels in frame layout, width 0 = empty slot
+struct sprite_t {
+    uint8_t format;
+    uint16_t width;
+    uint16_t height;
+};
+static sprite_t sprites[SPRITE_SLOTS];
+static uint8_t sprite_data[SPRITE_SLOTS][SPRITE_BYTES] __attribute__((aligned(4)));
+
+// Characters of the PKT_DRAW_TEXT being received
+static uint8_t draw_chars[255];
+
+// One row span as 16-bit values (PKT_DRAW_SCROLL)
+static uint16_t draw_line[DISPLAY_WIDTH];
+static uint16_t draw_line_tmp[DISPLAY_WIDTH];
+
+static inline bool pkt_is_draw(uint8_t type) {
+    return type == PKT_DRAW_FILL || type == PKT_DRAW_BLIT || type == PKT_DRAW_SCROLL ||
+           type == PKT_DRAW_TEXT;
+}
+
+// Pixel x of a row at bits per pixel (P4: low nibble first)
+static inline uint16_t px_get(const uint8_t* row, int x, int bits) {
+    if (bits == 16) {
+        return ((const uint16_t*)row)[x];
+    }
+    if (bits == 8) {
+        return row[x];
+    }
+    return (row[x >> 1] >> ((x & 1) * 4)) & 0x0F;
+}
+
+static inline void px_put(uint8_t* row, int x, int bits, uint16_t v) {
+    if (bits == 16) {
+        ((uint16_t*)row)[x] = v;
+    } else if (bits == 8) {
+        row[x] = (uint8_t)v;
+    } else {
+        int shift = (x & 1) * 4;
+        row[x >> 1] = (row[x >> 1] & ~(0x0F << shift)) | ((v & 0x0F) << shift);
+    }
+}
+
+// Frame row y in frame_format
+static inline uint8_t* frame_row(int y) {
+    return (uint8_t*)frame_buffer + y * (DISPLAY_WIDTH * pixfmt_bits(frame_format) / 8);
+}
+
+static void frame_read_span(int x, int y, int width, uint16_t* out) {
+    int bits = pixfmt_bits(frame_format);
+    const uint8_t* row = frame_row(y);
+    for (int i = 0; i < width; i++) {
+        out[i] = px_get(row, x + i, bits);
+    }
+}
+
+static void frame_write_span(int x, int y, int width, const uint16_t* in) {
+    int bits = pixfmt_bits(frame_format);
+    uint8_t* row = frame_row(y);
+    for (int i = 0; i < width; i++) {
+        px_put(row, x + i, bits, in[i]);
+    }
+}
+
+static void frame_fill_span(int x, int y, int width, uint16_t v) {
+    int bits = pixfmt_bits(frame_format);
+    uint8_t* row = frame_row(y);
+    if (bits == 8) {
+        memset(row + x, v, width);
+        return;
+    }
+    for (int i = 0; i < width; i++) {
+        px_put(row, x + i, bits, v);
+    }
+}
+
+// Each draw_* returns the scan rows it changed. Fields were checked by
+// rx_fields_done (format and bounds; BLIT and TEXT clip here).
+static uint32_t draw_fill(const pkt_fill_t& fill, uint8_t format) {
+    frame_format = format;  // Only differs for a whole-display fill
+    int x = DISPLAY_WIDTH - fill.x - fill.width;
+    for (int y = fill.y; y < fill.y + fill.height; y++) {
+        frame_fill_span(x, y, fill.width, fill.color);
+    }
+    return scan_rows_mask(fill.y, fill.y + fill.height);
+}
+
+static uint32_t draw_blit(const pkt_blit_t& blit) {
+    const sprite_t& sprite = sprites[blit.slot];
+    const uint8_t* data = sprite_data[blit.slot];
+    int bits = pixfmt_bits(sprite.format);
+    uint32_t stride = sprite.width * bits / 8;
+
+    // Frame column of sprite column 0 (sprites are stored in frame layout)
+    int left = DISPLAY_WIDTH - blit.x - sprite.width;
+    int x0 = left > 0 ? left : 0;
+    int x1 = left + sprite.width < DISPLAY_WIDTH ? left + sprite.width : DISPLAY_WIDTH;
+    int y0 = blit.y > 0 ? blit.y : 0;
+    int y1 = blit.y + sprite.height < DISPLAY_HEIGHT ? blit.y + sprite.height : DISPLAY_HEIGHT;
+    if (x0 >= x1 || y0 >= y1) {
+        return 0;
+    }
+
+    bool key = (blit.flags & BLIT_FLAG_KEY) != 0;
+    for (int y = y0; y < y1; y++) {
+        const uint8_t* src = data + (y - blit.y) * stride;
+        uint8_t* dst = frame_row(y);
+        if (!key && bits != 4) {
+            memcpy(dst + x0 * bits / 8, src + (x0 - left) * bits / 8, (x1 - x0) * bits / 8);
+            continue;
+        }
+        for (int x = x0; x < x1; x++) {
+            uint16_t v = px_get(src, x - left, bits);
+            if (!key || v != blit.key) {
+                px_put(dst, x, bits, v);
+            }
+        }
+    }
+    return scan_rows_mask(y0, y1);
+}
+
+static uint32_t draw_scroll(const pkt_scroll_t& scroll) {
+    int w = scroll.width;
+    int h = scroll.height;
+    int x = DISPLAY_WIDTH - scroll.x - w;
+    int sx = ((-scroll.dx) % w + w) % w;  // Display right is frame left
+    int sy = (scroll.dy % h + h) % h;
+
+    if (sy) {
+        // Rows move down by sy: follow each cycle of the rotation from its
+        // first row, so only one row is held at a time
+        int moved = 0;
+        for (int start = 0; moved < h; start++) {
+            frame_read_span(x, scroll.y + start, w, draw_line);
+            int j = start;
+            for (;;) {
+                int src = (j - sy + h) % h;
+                if (src == start) {
+                    break;
+                }
+                frame_read_span(x, scroll.y + src, w, draw_line_tmp);
+                frame_write_span(x, scroll.y + j, w, draw_line_tmp);
+                j = src;
+                moved++;
+            }
+            frame_write_span(x, scroll.y + j, w, draw_line);
+            moved++;
+        }
+    }
+    if (sx) {
+        for (int y = scroll.y; y < scroll.y + h; y++) {
+            frame_read_span(x, y, w, draw_line);
+            frame_write_span(x + sx, y, w - sx, draw_line);
+            frame_write_span(x, y, sx, draw_line + w - sx);
+        }
+    }
+    return sx || sy ? scan_rows_mask(scroll.y, scroll.y + h) : 0;
+}
+
+static uint32_t draw_text(const pkt_text_t& text) {
+    int bits = pixfmt_bits(frame_format);
+    bool background = (text.flags & TEXT_FLAG_BACKGROUND) != 0;
+    int y0 = text.y > 0 ? text.y : 0;
+    int y1 = text.y + FONT_CELL_HEIGHT;
+    if (y1 > DISPLAY_HEIGHT) {
+        y1 = DISPLAY_HEIGHT;
+    }
+    if (y0 >= y1) {
+        return 0;
+    }
+
+    bool drawn = false;
+    for (int i = 0; i < text.length; i++) {
+        int cell = text.x + i * FONT_CELL_WIDTH;
+        if (cell >= DISPLAY_WIDTH) {
+            break;
+        }
+        uint8_t c = draw_chars[i];
+        if (c < FONT_FIRST || c > FONT_LAST) {
+            c = '?';
+        }
+        const uint8_t* glyph = font_5x7[c - FONT_FIRST];
+        for (int col = 0; col < FONT_CELL_WIDTH; col++) {
+            int dx = cell + col;
+            if (dx < 0 || dx >= DISPLAY_WIDTH) {
+                continue;
+            }
+            int fx = DISPLAY_WIDTH - 1 - dx;
+            uint8_t dots = col < FONT_WIDTH ? glyph[col] : 0;
+            for (int y = y0; y < y1; y++) {
+                if ((dots >> (y - text.y)) & 1) {
+                    px_put(frame_row(y), fx, bits, text.color);
+                } else if (background) {
+                    px_put(frame_row(y), fx, bits, text.background);
+                }
+            }
+            drawn = true;
+        }
+    }
+    return drawn ? scan_rows_mask(y0, y1) : 0;
+}
+
+// Run a complete drawing packet (body: its fields after header and PTS)
+static uint32_t draw_execute(uint8_t type, uint8_t format, const uint8_t* body) {
+    if (type == PKT_DRAW_FILL) {
+        pkt_fill_t fill;
+        memcpy(&fill, body, sizeof(fill));
+        return draw_fill(fill, format);
+    }
+    if (type == PKT_DRAW_BLIT) {
+        pkt_blit_t blit;
+        memcpy(&blit, body, sizeof(blit));
+        return draw_blit(blit);
+    }
+    if (type == PKT_DRAW_SCROLL) {
+        pkt_scroll_t scroll;
+        memcpy(&scroll, body, sizeof(scroll));
+        return draw_scroll(scroll);
+    }
+    pkt_text_t text;
+    memcpy(&text, body, sizeof(text));
+    return draw_text(text);
+}
+
+// ============================================
+// Streaming packet receiver
+// ============================================
+// COBS is decoded as bytes arrive and pixel data is written straight into
+// its place in frame_buffer, so no copy of the packet is ever staged. The
+// header (and rows/rect/palette fields) is collected first to pick the
+// destination. A frame packet only takes effect once it has ended cleanly;
+// the rows a bad one wrote are restored from the previous slot.
+enum rx_state_t : uint8_t {
+    RX_HEADER,      // Collecting header / body fields
+    RX_PIXELS,      // Writing pixels into the destination rectangle
+    RX_DISCARD,     // Rejected, skipping to the next delimiter
+};
+
+// Header, PTS and the largest body fields
+#define RX_FIELDS_MAX   (sizeof(pkt_header_t) + sizeof(pkt_pts_t) + sizeof(pkt_scroll_t))
+
+// COBS state
+static uint8_t rx_block_left = 0;       // Literal bytes left in current block
+static bool rx_zero_pending = false;    // Current block ends in an implicit 0x00
+
+// Packet state
+static rx_state_t rx_state = RX_HEADER;
+static bool rx_legacy = false;
+static uint8_t rx_fields[RX_FIELDS_MAX];
+static uint8_t rx_fields_len = 0;
+static uint8_t rx_fields_need = sizeof(pkt_header_t);
+static uint8_t rx_type = 0;             // PKT_* of the current packet
+static uint8_t rx_format = PIXFMT_RGB565;
+static bool rx_has_pts = false;         // pkt_pts_t right after the header
+static bool rx_rle = false;             // Pixel data is run-length coded
+
+// Run-length decoder (PKT_FLAG_RLE): bytes per unit, literal bytes left in
+// the current run, or a repeat run waiting for (the rest of) its unit
+static uint8_t rle_unit = 2;
+static uint32_t rle_literal = 0;
+static uint8_t rle_repeat = 0;
+static uint8_t rle_value[2];
+static uint8_t rle_value_len = 0;
+
+// Host clock (PKT_CLOCK): host microseconds minus device microseconds
+static bool clock_synced = false;
+static uint32_t clock_offset = 0;
+
+// PKT_STATS query to answer (from loop(), like credit reports)
+static bool rx_stats_pending = false;
+
+// Channel curve / palette entries being received, applied only once the
+// packet is complete
+static uint16_t rx_lut[LUT_ENTRIES_MAX];
+static uint8_t rx_palette[256][3];
+
+// Frame update being received: the scan rows it changes and the bytes of
+// frame_buffer it writes, [rx_frame_begin, rx_frame_end)
+static bool rx_frame_target = false;
+static uint32_t rx_frame_rows = 0;
+static uint32_t rx_frame_begin = 0;
+static uint32_t rx_frame_end = 0;
+
+#if FRAME_SLOTS == 1
+// No previous slot to restore from: scan rows a bad packet wrote stay out
+// of conversions until a whole frame replaces them
+static uint32_t frame_damaged = 0;
+#endif
+
+// Packets fed from a flash clip: display packets only, never counted or
+// reported; rx_clip_frame is set once a frame packet has ended
+static bool rx_from_clip = false;
+static bool rx_clip_frame = false;
+
+// Destination rectangle (frame_buffer, rx_palette, rx_lut or a sprite)
+static uint8_t* rx_dst = nullptr;       // Next byte on the current line
+static uint32_t rx_line_bytes = 0;
+static uint32_t rx_line_left = 0;
+static uint32_t rx_stride = 0;          // Bytes from one line start to the next
+static uint32_t rx_lines_left = 0;
+static uint32_t rx_extra = 0;           // Bytes past the rectangle (pad)
+
+static void rx_reset() {
+    rx_block_left = 0;
+    rx_zero_pending = false;
+    rx_state = RX_HEADER;
+    rx_legacy = false;
+    rx_type = 0;
+    rx_has_pts = false;
+    rx_rle = false;
+    rle_literal = 0;
+    rle_repeat = 0;
+    rx_fields_len = 0;
+    rx_fields_need = sizeof(pkt_header_t);
+    rx_lines_left = 0;
+    rx_extra = 0;
+    rx_frame_target = false;
+}
+
+// Undo a bad frame packet's writes to frame_buffer (in frame_format, which
+// it has not changed)
+static void rx_frame_restore() {
+    uint32_t size = sizeof(frame_slots[0]) * pixfmt_bits(frame_format) / 16;
+    uint32_t end = rx_frame_end < size ? rx_frame_end : size;
+    if (rx_frame_begin >= end) {
+        return;
+    }
+#if FRAME_SLOTS > 1
+    const uint8_t* prev = (const uint8_t*)frame_slots[(rx_slot + FRAME_SLOTS - 1) % FRAME_SLOTS];
+    memcpy((uint8_t*)frame_buffer + rx_frame_begin, prev + rx_frame_begin, end - rx_frame_begin);
+#else
+    frame_damaged |= rx_frame_rows;
+#endif
+}
+
+// Host frame packet (counted against PKT_CREDIT) being received
+static inline bool rx_is_frame() {
+    return rx_legacy || rx_type == PKT_FRAME_FULL || rx_type == PKT_FRAME_ROWS ||
+           rx_type == PKT_FRAME_RECT || pkt_is_draw(rx_type);
+}
+
+// Packet rejected or cut short: nothing is converted for it, so a host
+// frame packet's credit is returned right away
+static void rx_abort() {
+    if (rx_frame_target) {
+        rx_frame_restore();
+    }
+    if (rx_is_frame() && !rx_from_clip) {
+        rx_frames_done++;
+        rx_credit_pending = true;
+    }
+    rx_reset();
+}
+
+static void rx_set_target(uint8_t* dst, uint32_t line_bytes, uint32_t stride, uint32_t lines) {
+    rx_dst = dst;
+    rx_line_bytes = line_bytes;
+    rx_line_left = line_bytes;
+    rx_stride = stride;
+    rx_lines_left = lines;
+    rx_state = RX_PIXELS;
+}
+
+// Pixels [x, x + width) x [y, y + height) of frame_buffer in rx_format.
+// Returns false if the update is not allowed.
+static bool rx_set_frame_target(int x, int y, int width, int height) {
+    int bits = pixfmt_bits(rx_format);
+    if (bits == 0) {
+        return false;
+    }
+    // Changing format needs a whole frame; P4 updates cover whole bytes
+    if (rx_format != frame_format && (width != DISPLAY_WIDTH || height != DISPLAY_HEIGHT)) {
+        return false;
+    }
+    if (bits == 4 && ((x | width) & 1)) {
+        return false;
+    }
+
+    uint32_t stride = DISPLAY_WIDTH * bits / 8;
+    uint32_t begin = y * stride + x * bits / 8;
+    rx_set_target((uint8_t*)frame_buffer + begin, width * bits / 8, stride, height);
+    rle_unit = bits == 16 ? 2 : 1;
+
+    // Format and rows apply once the packet completes (rx_end)
+    rx_frame_target = true;
+    rx_frame_rows = scan_rows_mask(y, y + height);
+    rx_frame_begin = begin;
+    rx_frame_end = begin + (height - 1) * stride + width * bits / 8;
+    return true;
+}
+
+// Sprite slot for a PKT_SPRITE upload in rx_format. Returns false if the
+// sprite does not fit; the slot stays empty until the upload completes.
+static bool rx_set_sprite_target(const pkt_sprite_t& sprite) {
+    if (sprite.slot >= SPRITE_SLOTS) {
+        return false;
+    }
+    sprites[sprite.slot].width = 0;
+
+    int bits = pixfmt_bits(rx_format);
+    uint32_t stride = sprite.width * bits / 8;
+    if (bits == 0 || sprite.width == 0 || sprite.height == 0 ||
+        (bits == 4 && (sprite.width & 1)) || stride * sprite.height > SPRITE_BYTES) {
+        return false;
+    }
+    rx_set_target(sprite_data[sprite.slot], stride, stride, sprite.height);
+    rle_unit = bits == 16 ? 2 : 1;
+    return true;
+}
+
+static void __not_in_flash_func(rx_pixels)(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        if (rx_lines_left == 0) {
+            rx_extra += len;
+            return;
+        }
+        size_t n = len < rx_line_left ? len : rx_line_left;
+        memcpy(rx_dst, data, n);
+        rx_dst += n;
+        rx_line_left -= n;
+        data += n;
+        len -= n;
+
+        if (rx_line_left == 0) {
+            rx_dst += rx_stride - rx_line_bytes;
+            rx_line_left = rx_line_bytes;
+            rx_lines_left--;
+        }
+    }
+}
+
+// count copies of a unit into the rectangle, like rx_pixels
+static void __not_in_flash_func(rx_fill)(const uint8_t* value, uint32_t count) {
+    while (count > 0) {
+        if (rx_lines_left == 0) {
+            rx_extra += count * rle_unit;
+            return;
+        }
+        uint32_t n = count < rx_line_left / rle_unit ? count : rx_line_left / rle_unit;
+        if (rle_unit == 1) {
+            memset(rx_dst, value[0], n);
+        } else {
+            // RGB565 rows and columns are 2-byte aligned in frame_buffer
+            uint16_t v = value[0] | (value[1] << 8);
+            uint16_t* dst = (uint16_t*)rx_dst;
+            for (uint32_t i = 0; i < n; i++) {
+                dst[i] = v;
+            }
+        }
+        rx_dst += n * rle_unit;
+        rx_line_left -= n * rle_unit;
+        count -= n;
+
+        if (rx_line_left == 0) {
+            rx_dst += rx_stride - rx_line_bytes;
+            rx_line_left = rx_line_bytes;
+            rx_lines_left--;
+        }
+    }
+}
+
+// Run-length coded pixel data (PKT_FLAG_RLE), any chunking
+static void __not_in_flash_func(rx_rle_pixels)(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        if (rx_lines_left == 0) {
+            // Rectangle full: only a pad byte may follow
+            rx_extra += len;
+            return;
+        }
+        if (rle_literal > 0) {
+            size_t n = len < rle_literal ? len : rle_literal;
+            rx_pixels(data, n);
+            rle_literal -= n;
+            data += n;
+            len -= n;
+            continue;
+        }
+        if (rle_repeat > 0) {
+            rle_value[rle_value_len++] = *data++;
+            len--;
+            if (rle_value_len == rle_unit) {
+                rx_fill(rle_value, rle_repeat);
+                rle_repeat = 0;
+            }
+            continue;
+        }
+
+        uint8_t c = *data++;
+        len--;
+        if (c < 0x80) {
+            rle_literal = (c + 1) * rle_unit;
+        } else {
+            rle_repeat = c - 0x7E;
+            rle_value_len = 0;
+        }
+    }
+}
+
+// Header / body fields complete: choose the destination or reject
+static void rx_fields_done() {
+    pkt_header_t hdr;
+    memcpy(&hdr, rx_fields, sizeof(hdr));
+
+    if (rx_fields_need == sizeof(hdr)) {
+        if (hdr.magic != PROTO_MAGIC || hdr.version != PROTO_VERSION) {
+            // Legacy raw frame: the "header" was its first pixels
+            rx_legacy = true;
+            rx_format = PIXFMT_RGB565;
+            if (!rx_set_frame_target(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT)) {
+                rx_state = RX_DISCARD;
+                return;
+            }
+            rx_pixels(rx_fields, rx_fields_len);
+            return;
+        }
+        rx_type = hdr.type;
+        rx_format = hdr.flags & PKT_FORMAT_MASK;
+        rx_has_pts = (hdr.flags & PKT_FLAG_PTS) != 0;
+        rx_rle = (hdr.flags & PKT_FLAG_RLE) != 0;
+        bool frame = hdr.type == PKT_FRAME_FULL || hdr.type == PKT_FRAME_ROWS ||
+                     hdr.type == PKT_FRAME_RECT;
+        if ((rx_has_pts && !frame && !pkt_is_draw(hdr.type)) ||
+            (rx_rle && !frame && hdr.type != PKT_SPRITE)) {
+            // Frame / drawing packet flags
+            rx_state = RX_DISCARD;
+            return;
+        }
+        if (rx_has_pts) {
+            // Presentation time, read with the body fields
+            rx_fields_need += sizeof(pkt_pts_t);
+        }
+        if (rx_from_clip && hdr.type >= PKT_CREDIT && hdr.type <= PKT_STATS) {
+            // Host link packets
+            rx_state = RX_DISCARD;
+            return;
+        }
+        switch (hdr.type) {
+        case PKT_FRAME_FULL:
+            if (!rx_has_pts && !rx_set_frame_target(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT)) {
+                rx_state = RX_DISCARD;
+            }
+            return;
+        case PKT_FRAME_ROWS:
+            rx_fields_need += sizeof(pkt_rows_t);
+            return;
+        case PKT_FRAME_RECT:
+            rx_fields_need += sizeof(pkt_rect_t);
+            return;
+        case PKT_PALETTE:
+            rx_fields_need += sizeof(pkt_palette_t);
+            return;
+        case PKT_DEPTH:
+            rx_fields_need += sizeof(pkt_depth_t);
+            return;
+        case PKT_BRIGHTNESS:
+            rx_fields_need += sizeof(pkt_brightness_t);
+            return;
+        case PKT_LUT:
+            rx_fields_need += sizeof(pkt_lut_t);
+            return;
+        case PKT_CREDIT:
+            rx_fields_need += sizeof(pkt_credit_t);
+            return;
+        case PKT_CLOCK:
+            rx_fields_need += sizeof(pkt_clock_t);
+            return;
+        case PKT_STATS:
+            rx_set_target(nullptr, 0, 0, 0);  // Query has no body
+            return;
+        case PKT_DRAW_FILL:
+            rx_fields_need += sizeof(pkt_fill_t);
+            return;
+        case PKT_SPRITE:
+            rx_fields_need += sizeof(pkt_sprite_t);
+            return;
+        case PKT_DRAW_BLIT:
+            rx_fields_need += sizeof(pkt_blit_t);
+            return;
+        case PKT_DRAW_SCROLL:
+            rx_fields_need += sizeof(pkt_scroll_t);
+            return;
+        case PKT_DRAW_TEXT:
+            rx_fields_need += sizeof(pkt_text_t);
+            return;
+#if HUB75_USE_CLIPS
+        case PKT_CLIP_DATA:
+            rx_fields_need += sizeof(pkt_clip_data_t);
+            return;
+        case PKT_CLIP_SAVE:
+            rx_fields_need += sizeof(pkt_clip_save_t);
+            return;
+        case PKT_CLIP_PLAY:
+            rx_fields_need += sizeof(pkt_clip_play_t);
+            return;
+#endif
+        default:
+            rx_state = RX_DISCARD;
+            return;
+        }
+    }
+
+    const uint8_t* body = rx_fields + sizeof(hdr) + (rx_has_pts ? sizeof(pkt_pts_t) : 0);
+    bool ok = false;
+    if (rx_type == PKT_FRAME_FULL) {
+        ok = rx_set_frame_target(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    } else if (rx_type == PKT_FRAME_ROWS) {
+        pkt_rows_t rows;
+        memcpy(&rows, body, sizeof(rows));
+        ok = rows.height != 0 && rows.y + rows.height <= DISPLAY_HEIGHT &&
+             rx_set_frame_target(0, rows.y, DISPLAY_WIDTH, rows.height);
+    } else if (rx_type == PKT_FRAME_RECT) {
+        pkt_rect_t rect;
+        memcpy(&rect, body, sizeof(rect));
+        ok = rect.width != 0 && rect.height != 0 &&
+             rect.x + rect.width <= DISPLAY_WIDTH && rect.y + rect.height <= DISPLAY_HEIGHT &&
+             rx_set_frame_target(rect.x, rect.y, rect.width, rect.height);
+    } else if (rx_type == PKT_PALETTE) {
+        pkt_palette_t pal;
+        memcpy(&pal, body, sizeof(pal));
+        ok = pal.count != 0 && pal.first + pal.count <= 256;
+        if (ok) {
+            rx_set_target(rx_palette[0], pal.count * 3, pal.count * 3, 1);
+        }
+    } else if (rx_type == PKT_DEPTH) {
+        pkt_depth_t depth;
+        memcpy(&depth, body, sizeof(depth));
+        ok = (depth.depth == 4 || depth.depth == 6 || depth.depth == 8 || depth.depth == 10) &&
+             depth.depth <= COLOR_DEPTH;
+        if (ok) {
+            rx_set_target(nullptr, 0, 0, 0);  // No payload
+        }
+    } else if (rx_type == PKT_DRAW_FILL) {
+        pkt_fill_t fill;
+        memcpy(&fill, body, sizeof(fill));
+        bool whole = fill.width == DISPLAY_WIDTH && fill.height == DISPLAY_HEIGHT;
+        ok = fill.width != 0 && fill.height != 0 &&
+             fill.x + fill.width <= DISPLAY_WIDTH && fill.y + fill.height <= DISPLAY_HEIGHT &&
+             (rx_format == frame_format || (whole && pixfmt_bits(rx_format) != 0));
+        if (ok) {
+            rx_set_target(nullptr, 0, 0, 0);
+        }
+    } else if (rx_type == PKT_SPRITE) {
+        pkt_sprite_t sprite;
+        memcpy(&sprite, body, sizeof(sprite));
+        ok = rx_set_sprite_target(sprite);
+    } else if (rx_type == PKT_DRAW_BLIT) {
+        pkt_blit_t blit;
+        memcpy(&blit, body, sizeof(blit));
+        ok = blit.slot < SPRITE_SLOTS && sprites[blit.slot].width != 0 &&
+             sprites[blit.slot].format == frame_format && rx_format == frame_format;
+        if (ok) {
+            rx_set_target(nullptr, 0, 0, 0);
+        }
+    } else if (rx_type == PKT_DRAW_SCROLL) {
+        pkt_scroll_t scroll;
+        memcpy(&scroll, body, sizeof(scroll));
+        ok = scroll.width != 0 && scroll.height != 0 &&
+             scroll.x + scroll.width <= DISPLAY_WIDTH &&
+             scroll.y + scroll.height <= DISPLAY_HEIGHT && rx_format == frame_format;
+        if (ok) {
+            rx_set_target(nullptr, 0, 0, 0);
+        }
+    } else if (rx_type == PKT_DRAW_TEXT) {
+        pkt_text_t text;
+        memcpy(&text, body, sizeof(text));
+        ok = text.length != 0 && rx_format == frame_format;
+        if (ok) {
+            rx_set_target(draw_chars, text.length, text.length, 1);
+        }
+    } else if (rx_type == PKT_BRIGHTNESS || rx_type == PKT_CREDIT || rx_type == PKT_CLOCK) {
+        // Every level / count / time is valid
+        rx_set_target(nullptr, 0, 0, 0);
+        ok = true;
+#if HUB75_USE_CLIPS
+    } else if (rx_type == PKT_CLIP_DATA) {
+        pkt_clip_data_t data;
+        memcpy(&data, body, sizeof(data));
+        ok = clip_page_valid(data);
+        if (ok) {
+            rx_set_target(clip_page, CLIP_PAGE_SIZE, CLIP_PAGE_SIZE, 1);
+        }
+    } else if (rx_type == PKT_CLIP_SAVE) {
+        pkt_clip_save_t save;
+        memcpy(&save, body, sizeof(save));
+        ok = clip_save_valid(save);
+        if (ok) {
+            rx_set_target(nullptr, 0, 0, 0);
+        }
+    } else if (rx_type == PKT_CLIP_PLAY) {
+        pkt_clip_play_t play;
+        memcpy(&play, body, sizeof(play));
+        ok = play.clip == CLIP_STOP || clip_saved(play.clip) != nullptr;
+        if (ok) {
+            rx_set_target(nullptr, 0, 0, 0);
+        }
+#endif
+    } else {
+        pkt_lut_t lut;
+        memcpy(&lut, body, sizeof(lut));
+        ok = lut.channel < 3;
+        if (ok) {
+            uint32_t bytes = lut_entries[lut.channel] * sizeof(uint16_t);
+            rx_set_target((uint8_t*)rx_lut, bytes, bytes, 1);
+        }
+    }
+    if (!ok) {
+        rx_state = RX_DISCARD;
+    }
+}
+
+// Decoded packet bytes
+static void __not_in_flash_func(rx_data)(const uint8_t* data, size_t len) {
+    while (len > 0 && rx_state == RX_HEADER) {
+        size_t n = rx_fields_need - rx_fields_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(&rx_fields[rx_fields_len], data, n);
+        rx_fields_len += n;
+        data += n;
+        len -= n;
+        if (rx_fields_len == rx_fields_need) {
+            rx_fields_done();
+        }
+    }
+    if (len > 0 && rx_state == RX_PIXELS) {
+        if (rx_rle) {
+            rx_rle_pixels(data, len);
+        } else {
+            rx_pixels(data, len);
+        }
+    }
+}
+
+// Packet delimiter: queue the update for conversion if the packet was
+// complete. Returns false if rejected.
+static bool rx_end() {
+    // Versioned packets may carry one pad byte (see hub75_protocol.h)
+    bool ok = rx_state == RX_PIXELS && rx_block_left == 0 &&
+              rx_lines_left == 0 && rx_extra <= (rx_legacy ? 0u : 1u);
+    bool frame = rx_is_frame();
+    // Host packets only: clip playback is not host traffic
+    if (!rx_from_clip) {
+        if (ok) {
+            stats_packets++;
+        } else if (rx_state != RX_HEADER || rx_fields_len != 0) {
+            stats_dropped++;  // Empty packets (back-to-back delimiters) are resyncs
+        }
+    }
+    if (ok && rx_frame_target) {
+        frame_format = rx_format;
+        frame_dirty |= rx_frame_rows;
+#if FRAME_SLOTS == 1
+        // A whole frame replaces any damaged rows
+        if (rx_frame_begin == 0 &&
+            rx_frame_end == (uint32_t)(FRAME_SIZE_RGB565 * pixfmt_bits(rx_format) / 16)) {
+            frame_damaged = 0;
+        }
+#endif
+    }
+
+    // New tables apply from this packet on: queued frames convert with the old ones.
+    // A credit reset counts from here: queued frames report theirs first.
+    if (ok && (rx_type == PKT_PALETTE || rx_type == PKT_LUT || rx_type == PKT_DEPTH ||
+               rx_type == PKT_CREDIT)) {
+        convert_drain(0);
+    }
+    if (ok && rx_type == PKT_PALETTE) {
+        pkt_palette_t pal;
+        memcpy(&pal, rx_fields + sizeof(pkt_header_t), sizeof(pal));
+        memcpy(palette_rgb[pal.first], rx_palette, pal.count * 3);
+        update_palette_lut(pal.first, pal.count);
+
+        // Every shown index may have changed colour
+        if (frame_format == PIXFMT_P8 || frame_format == PIXFMT_P4) {
+            frame_dirty = BCM_ALL_ROWS;
+        }
+    }
+    if (ok && rx_type == PKT_BRIGHTNESS) {
+        pkt_brightness_t brightness;
+        memcpy(&brightness, rx_fields + sizeof(pkt_header_t), sizeof(brightness));
+        set_bcm_brightness(brightness.level);
+    }
+    if (ok && rx_type == PKT_LUT) {
+        pkt_lut_t lut;
+        memcpy(&lut, rx_fields + sizeof(pkt_header_t), sizeof(lut));
+        memcpy(channel_lut[lut.channel], rx_lut, lut_entries[lut.channel] * sizeof(uint16_t));
+        spread_channel(lut.channel);
+
+        if (frame_format == PIXFMT_RGB565) {
+            frame_dirty = BCM_ALL_ROWS;
+        }
+    }
+    if (ok && rx_type == PKT_DEPTH) {
+        pkt_depth_t depth;
+        memcpy(&depth, rx_fields + sizeof(pkt_header_t), sizeof(depth));
+        if (depth.depth != bcm_depth) {
+            set_bcm_depth(depth.depth);
+            frame_dirty = BCM_ALL_ROWS;
+        }
+    }
+    if (ok && rx_type == PKT_CREDIT) {
+        pkt_credit_t credit;
+        memcpy(&credit, rx_fields + sizeof(pkt_header_t), sizeof(credit));
+        rx_frames_done = credit.frames;
+        rx_credit_pending = true;
+    }
+    if (ok && rx_type == PKT_STATS) {
+        rx_stats_pending = true;
+    }
+    if (ok && rx_type == PKT_CLOCK) {
+        pkt_clock_t clock;
+        memcpy(&clock, rx_fields + sizeof(pkt_header_t), sizeof(clock));
+        clock_offset = clock.time_us - time_us_32();
+        clock_synced = true;
+    }
+    if (ok && rx_type == PKT_SPRITE) {
+        pkt_sprite_t sprite;
+        memcpy(&sprite, rx_fields + sizeof(pkt_header_t), sizeof(sprite));
+        sprites[sprite.slot] = {rx_format, sprite.width, sprite.height};
+    }
+    if (ok && pkt_is_draw(rx_type)) {
+        const uint8_t* body = rx_fields + sizeof(pkt_header_t) +
+                              (rx_has_pts ? sizeof(pkt_pts_t) : 0);
+        frame_dirty |= draw_execute(rx_type, rx_format, body);
+    }
+#if HUB75_USE_CLIPS
+    if (ok && rx_type == PKT_CLIP_DATA) {
+        pkt_clip_data_t data;
+        memcpy(&data, rx_fields + sizeof(pkt_header_t), sizeof(data));
+        clip_write_page(data);
+    }
+    if (ok && rx_type == PKT_CLIP_SAVE) {
+        pkt_clip_save_t save;
+        memcpy(&save, rx_fields + sizeof(pkt_header_t), sizeof(save));
+        clip_save(save);
+    }
+    if (ok && rx_type == PKT_CLIP_PLAY) {
+        pkt_clip_play_t play;
+        memcpy(&play, rx_fields + sizeof(pkt_header_t), sizeof(play));
+        clip_play(play.clip);
+    }
+#endif
+    bool timed = false;
+    uint32_t at = 0;
+    if (ok && rx_has_pts && clock_synced && !rx_from_clip) {
+        // Host time -> device time, attached when this frame is published
+        pkt_pts_t pts;
+        memcpy(&pts, rx_fields + sizeof(pkt_header_t), sizeof(pts));
+        timed = true;
+        at = pts.time_us - clock_offset;
+    }
+
+    if (frame && rx_from_clip) {
+        rx_clip_frame = true;
+    }
+#if HUB75_USE_CLIPS
+    if (frame && !rx_from_clip) {
+        clip_stop();  // The host takes the display back
+    }
+#endif
+    if (!ok) {
+        rx_abort();
+        return false;
+    }
+
+    // A host frame packet frees its credit once converted, or now if it
+    // changed nothing
+    uint8_t credits = frame && !rx_from_clip ? 1 : 0;
+#if FRAME_SLOTS == 1
+    frame_dirty &= ~frame_damaged;
+#endif
+    if (frame_dirty) {
+        frame_submit(frame_dirty, timed, at, credits);
+        frame_dirty = 0;
+    } else if (credits) {
+        rx_frames_done++;
+        rx_credit_pending = true;
+    }
+    rx_reset();
+    return true;
+}
+
+// First 0x00 in data[0, len), or nullptr. Tests a word at a time once aligned.
+static inline const uint8_t* __not_in_flash_func(rx_find_delim)(const uint8_t* data, size_t len) {
+    const uint8_t* end = data + len;
+
+    while (data < end && ((uintptr_t)data & 3)) {
+        if (*data == 0x00) {
+            return data;
+        }
+        data++;
+    }
+    while (end - data >= 4) {
+        uint32_t w = *(const uint32_t*)data;
+        if ((w - 0x01010101u) & ~w & 0x80808080u) {
+            break;  // Some byte in this word is zero
+        }
+        data += 4;
+    }
+    while (data < end) {
+        if (*data == 0x00) {
+            return data;
         }
+        data++;
+    }
+    return nullptr;
+}
 
-        // Copy (code - 1) bytes
-        for (uint8_t i = 1; i < code && read_idx < len; i++) {
-            // Bounds check
-            if (write_idx >= max_output) {
-                return 0;  // Buffer overflow
+// Feed received (COBS-encoded) bytes, any chunking, delimiters included
+static void __not_in_flash_func(rx_feed)(const uint8_t* data, size_t len) {
+    static const uint8_t zero = 0x00;
+
+    while (len > 0) {
+        if (rx_block_left == 0) {
+            // Code byte (or delimiter)
+            uint8_t code = *data++;
+            len--;
+            if (code == 0x00) {
+                rx_end();
+                continue;
+            }
+            if (rx_zero_pending) {
+                rx_data(&zero, 1);
             }
-            output[write_idx++] = input[read_idx++];
+            rx_block_left = code - 1;
+            rx_zero_pending = code != 0xFF;
+            continue;
         }
 
-        // Add zero byte if code != 0xFF and not at end
-        if (code != 0xFF && read_idx < len) {
-            if (write_idx >= max_output) {
-                return 0;  // Buffer overflow
+        // Literal run, cut short if a delimiter arrives mid-block
+        size_t n = len < rx_block_left ? len : rx_block_left;
+        const uint8_t* delim = rx_find_delim(data, n);
+        if (delim) {
+            // Truncated packet: drop it and resync on this delimiter
+            if (!rx_from_clip) {
+                stats_cobs_errors++;
             }
-            output[write_idx++] = 0x00;
+            rx_abort();
+            n = delim - data + 1;
+            data += n;
+            len -= n;
+            continue;
         }
+        if (rx_state != RX_DISCARD) {
+            rx_data(data, n);
+        }
+        rx_block_left -= n;
+        data += n;
+        len -= n;
     }
-
-    return write_idx;
 }
 
+#if HUB75_USE_CLIPS
 // ============================================
-// Frame Buffers
-// ============================================
-// Simplified single-buffer approach for stable operation
-// (Reference: LED_Matrix_firmware_K00798)
-static uint16_t frame_buffer[DISPLAY_WIDTH * DISPLAY_HEIGHT];
-static volatile bool frame_ready = false;
-
-// BCM bit planes: [row][bit][x] = packed 6-bit RGB
-static uint8_t bcm_planes[SCAN_ROWS][COLOR_DEPTH][DISPLAY_WIDTH];
-
-// COBS receive buffer
-static uint8_t recv_buffer[RECV_BUFFER_SIZE];
-static size_t recv_pos = 0;
-
-// Decode buffer for COBS output
-static uint8_t decode_buffer[FRAME_SIZE_RGB565];
-
-// Gamma table
-static uint8_t gamma_tbl[256];
-
-// Boot screen complete flag
-static volatile bool boot_complete = false;
-
-#if HUB75_USE_PIO
-// PIO instance and state machine
-static PIO hub75_pio = pio0;
-static uint sm_data = 0;
-
-// DMA channel for PIO data transfer
-static int dma_chan = -1;
-
-// Double buffer for DMA (ping-pong)
-// Each pixel is expanded from 8-bit to 32-bit for PIO FIFO
-static uint32_t dma_buffer[2][DISPLAY_WIDTH];
-#endif
-
-// ============================================
-// Initialize gamma table
+// Clip playback (Core0)
 // ============================================
-void init_gamma(float gamma_val) {
-    for (int i = 0; i < 256; i++) {
-        float norm = (float)i / 255.0f;
-        gamma_tbl[i] = (uint8_t)(powf(norm, gamma_val) * 255.0f + 0.5f);
-    }
+// Between packets only: a clip packet never splits one still arriving
+// from the host
+static inline bool rx_idle() {
+    return rx_state == RX_HEADER && rx_fields_len == 0 && rx_block_left == 0 &&
+           !rx_zero_pending;
 }
 
-// ============================================
-// Convert RGB565 frame to BCM planes
-// ============================================
-void convert_to_bcm(uint16_t* pixels) {
-    for (int row = 0; row < SCAN_ROWS; row++) {
-        int y_upper = row;
-        int y_lower = row + SCAN_ROWS;
+// Once per interval, feed the clip up to and including its next frame
+// packet (palette / depth / ... packets before it apply on the way)
+static void clip_tick() {
+    if (!clip_pos || !boot_complete || !rx_idle()) {
+        return;
+    }
+    uint32_t now = time_us_32();
+    if ((int32_t)(now - clip_next_us) < 0) {
+        return;
+    }
+    // Fixed rate; after a stall (flash write, slow host packet) start over
+    clip_next_us += clip_interval_us;
+    if ((int32_t)(now - clip_next_us) >= 0) {
+        clip_next_us = now + clip_interval_us;
+    }
 
-        for (int x = 0; x < DISPLAY_WIDTH; x++) {
-            uint16_t p_up = pixels[y_upper * DISPLAY_WIDTH + x];
-            uint16_t p_lo = pixels[y_lower * DISPLAY_WIDTH + x];
-
-            // Extract and scale to 8-bit, then apply gamma
-            uint8_t r0 = gamma_tbl[((p_up >> 11) & 0x1F) << 3];
-            uint8_t g0 = gamma_tbl[((p_up >> 5) & 0x3F) << 2];
-            uint8_t b0 = gamma_tbl[(p_up & 0x1F) << 3];
-
-            uint8_t r1 = gamma_tbl[((p_lo >> 11) & 0x1F) << 3];
-            uint8_t g1 = gamma_tbl[((p_lo >> 5) & 0x3F) << 2];
-            uint8_t b1 = gamma_tbl[(p_lo & 0x1F) << 3];
-
-            // Scale 8-bit to COLOR_DEPTH bits
-            r0 >>= (8 - COLOR_DEPTH);
-            g0 >>= (8 - COLOR_DEPTH);
-            b0 >>= (8 - COLOR_DEPTH);
-            r1 >>= (8 - COLOR_DEPTH);
-            g1 >>= (8 - COLOR_DEPTH);
-            b1 >>= (8 - COLOR_DEPTH);
-
-            // Pack into bit planes
-            for (int bit = 0; bit < COLOR_DEPTH; bit++) {
-                uint8_t mask = 1 << bit;
-                uint8_t packed = 0;
-                if (r0 & mask) packed |= 0x01;
-                if (g0 & mask) packed |= 0x02;
-                if (b0 & mask) packed |= 0x04;
-                if (r1 & mask) packed |= 0x08;
-                if (g1 & mask) packed |= 0x10;
-                if (b1 & mask) packed |= 0x20;
-                bcm_planes[row][bit][x] = packed;
-            }
+    rx_from_clip = true;
+    rx_clip_frame = false;
+    while (!rx_clip_frame && clip_pos) {
+        const uint8_t* delim = rx_find_delim(clip_pos, clip_end - clip_pos);
+        if (!delim) {
+            clip_stop();  // Saved clips end on a delimiter
+            break;
+        }
+        rx_feed(clip_pos, delim + 1 - clip_pos);
+        clip_pos = delim + 1;
+        if (clip_pos == clip_end) {
+            clip_pos = clip_begin;
+            break;
         }
     }
+    rx_from_clip = false;
 }
+#endif
 
 // ============================================
 // HUB75 Initialize - GPIO only (for boot screen)
 // ============================================
-void hub75_gpio_init() {
-    // Initialize GPIO pins
-    for (int pin = PIN_R0; pin <= PIN_ADDR_D; pin++) {
+static void hub75_gpio_out(int first, int count) {
+    for (int pin = first; pin < first + count; pin++) {
         gpio_init(pin);
         gpio_set_dir(pin, GPIO_OUT);
         gpio_put(pin, 0);
     }
+}
+
+void hub75_gpio_init() {
+    // Initialize GPIO pins
+    hub75_gpio_out(PIN_R0, RGB_PINS);
+    hub75_gpio_out(PIN_CLK, 1);
+    hub75_gpio_out(PIN_LAT, 1);
+    hub75_gpio_out(PIN_OE, 1);
+    hub75_gpio_out(PIN_ADDR_A, N_ADDR_PINS);
     gpio_put(PIN_OE, 1);  // Display off
 
-    // Initialize gamma table
+    bcm_lsb_cycles = BCM_LSB_CYCLES ? BCM_LSB_CYCLES : clock_get_hz(clk_sys) / 1000000;
+    set_bcm_brightness(bcm_brightness);
+
+    // Initialize panel mapping, gamma table and BCM lookup tables
+    init_panel_map();
     init_gamma(2.2f);
+    init_bcm_lut();
 
     // Clear buffers
-    memset(frame_buffer, 0, sizeof(frame_buffer));
+    memset(frame_slots, 0, sizeof(frame_slots));
     memset(bcm_planes, 0, sizeof(bcm_planes));
 }
 
@@ -204,15 +2168,147 @@ void hub75_gpio_init() {
 // HUB75 Initialize - PIO (call after boot screen)
 // ============================================
 void hub75_pio_init() {
+#if HUB75_USE_DMA_CHAIN
+    // Data + row programs: takes over RGB, CLK, LAT, OE and address pins
+    uint offset = pio_add_program(hub75_pio, &hub75_data_chain_program);
+    hub75_data_chain_program_init(hub75_pio, sm_data, offset, PIN_R0, PIN_CLK, SHIFT_WIDTH);
+
+    offset = pio_add_program(hub75_pio, &hub75_row_program);
+    hub75_row_program_init(hub75_pio, sm_row, offset, PIN_ADDR_A, N_ADDR_PINS, PIN_LAT);
+#elif HUB75_PACKED_PLANES
+    // Packed data program: takes over the RGB pins and CLK
+    uint offset = pio_add_program(hub75_pio, &hub75_data_packed_program);
+    hub75_data_packed_program_init(hub75_pio, sm_data, offset, PIN_R0, PIN_CLK);
+#else
     // Load and init PIO program
-    // This takes over GP0-5 (RGB) and GP6 (CLK) from GPIO control
+    // This takes over the RGB pins and CLK from GPIO control
     uint offset = pio_add_program(hub75_pio, &hub75_data_program);
     hub75_data_program_init(hub75_pio, sm_data, offset, PIN_R0, PIN_CLK);
+#endif
+
+#if !HUB75_USE_DMA_CHAIN
+    // OE program: takes over OE from GPIO control
+    offset = pio_add_program(hub75_pio, &hub75_oe_program);
+    hub75_oe_program_init(hub75_pio, sm_oe, offset, PIN_OE);
+#endif
+}
+
+#if HUB75_USE_DMA_CHAIN
+// ============================================
+// DMA chain - control blocks and row words
+// ============================================
+// Rebuilt for the back buffer whenever its depth changes, and for both
+// buffers when the brightness changes. The chain may be reading the front
+// buffer then: its control blocks are rewritten with the same addresses
+// (same depth and planes), and each row word is one aligned 32-bit store
+// with an unchanged row address, so a sweep reads either the old or the
+// new on-time of a row but never a torn word.
+static void hub75_chain_build(int buf) {
+    int depth = bcm_buf_depth[buf];
+
+    for (int bit = 0; bit < depth; bit++) {
+        // hub75_row cannot blank a row entirely: 2 cycles minimum
+        uint32_t on_cycles = bcm_plane_cycles[bit] < 2 ? 2 : bcm_plane_cycles[bit];
+        for (int row = 0; row < SCAN_ROWS; row++) {
+            int step = bit * SCAN_ROWS + row;
+            for (int phase = 0; phase < BCM_PHASES; phase++) {
+                chain_blocks[buf][phase][step] = bcm_planes[buf][phase][row][bit];
+            }
+            row_words[buf][step] = ((on_cycles - 2) << 5) | (uint32_t)row;
+        }
+    }
+
+    // NULL read address = null trigger, ends the chain and raises the IRQ
+    for (int phase = 0; phase < BCM_PHASES; phase++) {
+        chain_blocks[buf][phase][depth * SCAN_ROWS] = NULL;
+    }
+}
+
+// hub75_row lights every row for at least 2 cycles, so brightness 0 holds
+// OE high (blank) with a pad override instead
+static void hub75_chain_blank() {
+    gpio_set_outover(PIN_OE, bcm_brightness ? GPIO_OVERRIDE_NORMAL : GPIO_OVERRIDE_HIGH);
+}
+
+// ============================================
+// DMA chain - start one frame from the front buffer
+// ============================================
+static inline void __not_in_flash_func(hub75_chain_arm)() {
+    // Frame boundary: pick up a newly converted frame and select this
+    // sweep's dither phase (the row words are the same for every phase)
+    bcm_take_front();
+    int phase = bcm_next_phase();
+
+    dma_channel_set_trans_count(dma_row_chan, bcm_buf_depth[bcm_front] * SCAN_ROWS, false);
+    dma_channel_set_read_addr(dma_row_chan, row_words[bcm_front], true);
+    dma_channel_set_read_addr(dma_ctrl_chan, chain_blocks[bcm_front][phase], true);
+}
+
+// ============================================
+// DMA chain - end of frame IRQ (Core1)
+// ============================================
+// Raised by the null trigger once every plane row has been queued to the
+// PIO. hub75_row trails the pixel stream by at most two rows (one lit, one
+// shifting), well within its FIFO, so the row channel has already drained
+// too and both can be restarted right away.
+static void __not_in_flash_func(hub75_chain_irq)() {
+    dma_hw->ints0 = 1u << dma_chan;
+    hub75_chain_arm();
 }
+#endif
 
 // ============================================
 // DMA Initialize - for PIO data transfer
 // ============================================
+#if HUB75_USE_DMA_CHAIN
+void hub75_dma_init() {
+    dma_chan = dma_claim_unused_channel(true);
+    dma_ctrl_chan = dma_claim_unused_channel(true);
+    dma_row_chan = dma_claim_unused_channel(true);
+
+    // Pixel channel: one packed plane row per trigger
+    dma_channel_config c = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(hub75_pio, sm_data, true));
+    channel_config_set_chain_to(&c, dma_ctrl_chan);
+    channel_config_set_irq_quiet(&c, true);  // IRQ on null trigger only
+    dma_channel_configure(dma_chan, &c, &hub75_pio->txf[sm_data], NULL,
+                          SHIFT_ROW_WORDS, false);
+
+    // Control channel: writes the next block into the pixel channel's
+    // read address trigger, then waits to be chained again
+    c = dma_channel_get_default_config(dma_ctrl_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(dma_ctrl_chan, &c, &dma_hw->ch[dma_chan].al3_read_addr_trig,
+                          NULL, 1, false);
+
+    // Row channel: paced by hub75_row TX FIFO
+    c = dma_channel_get_default_config(dma_row_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(hub75_pio, sm_row, true));
+    dma_channel_configure(dma_row_chan, &c, &hub75_pio->txf[sm_row], row_words[0],
+                          CHAIN_STEPS, false);
+
+    hub75_chain_build(0);
+    hub75_chain_build(1);
+
+    // A brightness set before the PIO took over OE (pin setup clears overrides)
+    hub75_chain_blank();
+
+    // End-of-frame IRQ on the core that calls this (Core1)
+    dma_channel_set_irq0_enabled(dma_chan, true);
+    irq_set_exclusive_handler(DMA_IRQ_0, hub75_chain_irq);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    hub75_chain_arm();
+}
+#else
 void hub75_dma_init() {
     // Claim a free DMA channel
     dma_chan = dma_claim_unused_channel(true);
@@ -237,6 +2333,7 @@ void hub75_dma_init() {
     dma_channel_set_write_addr(dma_chan, &hub75_pio->txf[sm_data], false);
 }
 #endif
+#endif
 
 // ============================================
 // HUB75 Initialize - Full (legacy, for non-PIO mode)
@@ -252,24 +2349,107 @@ void hub75_init() {
 // Set row address using direct register access
 // ============================================
 static inline void __not_in_flash_func(set_row_address)(int row) {
+    // Address pins are consecutive from PIN_ADDR_A
     sio_hw->gpio_clr = ADDR_MASK;
-    uint32_t addr_bits = (((row >> 0) & 1) << PIN_ADDR_A) |
-                         (((row >> 1) & 1) << PIN_ADDR_B) |
-                         (((row >> 2) & 1) << PIN_ADDR_C) |
-                         (((row >> 3) & 1) << PIN_ADDR_D);
-    sio_hw->gpio_set = addr_bits;
+    sio_hw->gpio_set = (uint32_t)row << PIN_ADDR_A;
 }
 
-#if HUB75_USE_PIO
+#if HUB75_USE_PIO && !HUB75_USE_DMA_CHAIN
+// ============================================
+// Wait until a state machine has run out of FIFO words
+// ============================================
+// A stalled SM keeps setting TXSTALL, so clearing it first is safe. With
+// autopull the data SM still holds up to 4 pixels when the FIFO runs
+// empty; it only stalls once the final clock pulse is done.
+static inline void __not_in_flash_func(hub75_wait_tx_stall)(uint sm) {
+    uint32_t txstall_mask = 1u << (PIO_FDEBUG_TXSTALL_LSB + sm);
+    hub75_pio->fdebug = txstall_mask;
+    while (!(hub75_pio->fdebug & txstall_mask)) {
+        tight_loop_contents();
+    }
+}
+
+// ============================================
+// BCM on-time of the latched row (hub75_oe)
+// ============================================
+// Started right after the latch and left running: the next row is shifted
+// while this one is lit, and only waited for just before its own latch.
+static inline void __not_in_flash_func(hub75_oe_start)(uint32_t cycles) {
+    pio_sm_put(hub75_pio, sm_oe, cycles - 1);
+}
+
+static inline void __not_in_flash_func(hub75_oe_wait)() {
+    hub75_wait_tx_stall(sm_oe);
+}
+#endif
+
+#if HUB75_USE_DMA_CHAIN
+// ============================================
+// HUB75 Refresh - DMA chain version
+// ============================================
+// The whole frame runs from DMA + PIO; the end-of-frame IRQ re-arms it.
+// Core1 just sleeps here and is free for other work.
+void __not_in_flash_func(hub75_refresh)() {
+    uint32_t start = systick_hw->cvr;
+    __wfi();
+    stats_idle_cycles += systick_elapsed(start);
+}
+
+#elif HUB75_PACKED_PLANES
+// ============================================
+// HUB75 Refresh - PIO + DMA version, packed planes
+// DMA reads plane rows in place, no per-row copy
+// ============================================
+void __not_in_flash_func(hub75_refresh)() {
+    // Pick up a newly converted frame only between full sweeps, then select
+    // this sweep's dither phase
+    const bcm_row_t* planes = bcm_take_front()[bcm_next_phase()];
+    int depth = bcm_buf_depth[bcm_front];
+
+    for (int bit = 0; bit < depth; bit++) {
+        uint32_t on_cycles = bcm_plane_cycles[bit];
+
+        for (int row = 0; row < SCAN_ROWS; row++) {
+            // 1. Start DMA straight from the plane row, the previous row stays lit
+            dma_channel_set_read_addr(dma_chan, planes[row][bit], false);
+            dma_channel_set_trans_count(dma_chan, SHIFT_ROW_WORDS, true);
+
+            // 2. Wait for DMA complete and PIO to finish shifting
+            uint32_t wait_start = systick_hw->cvr;
+            dma_channel_wait_for_finish_blocking(dma_chan);
+            hub75_wait_tx_stall(sm_data);
+
+            // 3. Wait for the previous row's on-time (hub75_oe blanks after it)
+            hub75_oe_wait();
+            stats_idle_cycles += systick_elapsed(wait_start);
+
+            // 4. Set row address
+            set_row_address(row);
+
+            // 5. Latch pulse
+            sio_hw->gpio_set = LAT_MASK;
+            __asm volatile("nop\nnop\nnop\nnop");
+            sio_hw->gpio_clr = LAT_MASK;
+
+            // 6. Start the BCM on-time (display time for this bit plane)
+            if (on_cycles) {
+                hub75_oe_start(on_cycles);
+            }
+        }
+    }
+}
+
+#elif HUB75_USE_PIO
 // ============================================
 // Prepare DMA buffer for a specific row/bit
 // ============================================
-static inline void __not_in_flash_func(prepare_dma_buffer)(int buf_idx, int row, int bit) {
-    uint8_t* row_data = bcm_planes[row][bit];
+static inline void __not_in_flash_func(prepare_dma_buffer)(const bcm_row_t* planes,
+                                                          int buf_idx, int row, int bit) {
+    const bcm_px_t* row_data = planes[row][bit];
     uint32_t* buf = dma_buffer[buf_idx];
-    for (int x = 0; x < DISPLAY_WIDTH; x++) {
+    for (int x = 0; x < SHIFT_WIDTH; x++) {
         // Reverse order for right-to-left shifting
-        buf[x] = row_data[DISPLAY_WIDTH - 1 - x];
+        buf[x] = row_data[SHIFT_WIDTH - 1 - x];
     }
 }
 
@@ -278,21 +2458,24 @@ static inline void __not_in_flash_func(prepare_dma_buffer)(int buf_idx, int row,
 // Double-buffered: prepares next row while current row is being transferred
 // ============================================
 void __not_in_flash_func(hub75_refresh)() {
+    // Pick up a newly converted frame only between full sweeps, then select
+    // this sweep's dither phase
+    const bcm_row_t* planes = bcm_take_front()[bcm_next_phase()];
+    int depth = bcm_buf_depth[bcm_front];
     int buf_idx = 0;
 
-    for (int bit = 0; bit < COLOR_DEPTH; bit++) {
-        uint32_t delay_us = 1 << bit;
+    for (int bit = 0; bit < depth; bit++) {
+        uint32_t on_cycles = bcm_plane_cycles[bit];
 
         for (int row = 0; row < SCAN_ROWS; row++) {
-            // 1. Disable output (blanking)
-            sio_hw->gpio_set = OE_MASK;
+            // 1. The previous row stays lit while this one is shifted
 
             // 2. Prepare current row's DMA buffer
-            prepare_dma_buffer(buf_idx, row, bit);
+            prepare_dma_buffer(planes, buf_idx, row, bit);
 
             // 3. Start DMA transfer
             dma_channel_set_read_addr(dma_chan, dma_buffer[buf_idx], false);
-            dma_channel_set_trans_count(dma_chan, DISPLAY_WIDTH, true);
+            dma_channel_set_trans_count(dma_chan, SHIFT_WIDTH, true);
 
             // 4. While DMA is running, prepare next buffer (pipelining)
             int next_buf = 1 - buf_idx;
@@ -302,35 +2485,34 @@ void __not_in_flash_func(hub75_refresh)() {
                 next_row = 0;
                 next_bit = bit + 1;
             }
-            if (next_bit < COLOR_DEPTH) {
-                prepare_dma_buffer(next_buf, next_row, next_bit);
+            if (next_bit < depth) {
+                prepare_dma_buffer(planes, next_buf, next_row, next_bit);
             }
 
             // 5. Wait for DMA complete
+            uint32_t wait_start = systick_hw->cvr;
             dma_channel_wait_for_finish_blocking(dma_chan);
 
-            // 6. Wait for PIO to finish shifting
-            while (!pio_sm_is_tx_fifo_empty(hub75_pio, sm_data)) {
-                tight_loop_contents();
-            }
-            __asm volatile("nop\nnop\nnop\nnop");
+            // 6. Wait for PIO to finish shifting: an empty FIFO still leaves
+            //    the last word in the OSR, the stall flag means it is out
+            hub75_wait_tx_stall(sm_data);
+
+            // 7. Wait for the previous row's on-time (hub75_oe blanks after it)
+            hub75_oe_wait();
+            stats_idle_cycles += systick_elapsed(wait_start);
 
-            // 7. Set row address
+            // 8. Set row address
             set_row_address(row);
 
-            // 8. Latch pulse
+            // 9. Latch pulse
             sio_hw->gpio_set = LAT_MASK;
             __asm volatile("nop\nnop\nnop\nnop");
             sio_hw->gpio_clr = LAT_MASK;
 
-            // 9. Enable output
-            sio_hw->gpio_clr = OE_MASK;
-
-            // 10. BCM delay (display time for this bit plane)
-            delayMicroseconds(delay_us);
-
-            // 11. Disable output before next row
-            sio_hw->gpio_set = OE_MASK;
+            // 10. Start the BCM on-time (display time for this bit plane)
+            if (on_cycles) {
+                hub75_oe_start(on_cycles);
+            }
 
             // Switch to next buffer
             buf_idx = next_buf;
@@ -343,11 +2525,11 @@ void __not_in_flash_func(hub75_refresh)() {
 // ============================================
 // Shift out one pixel data via GPIO (CPU version - fast register access)
 // ============================================
-static inline void __not_in_flash_func(shift_out_pixel)(uint8_t data) {
+static inline void __not_in_flash_func(shift_out_pixel)(bcm_px_t data) {
     // Clear RGB pins, then set the ones that should be high
-    // Data bits 0-5 map directly to GPIO 0-5
+    // Data bits map directly to the RGB pins from PIN_R0
     sio_hw->gpio_clr = RGB_MASK;
-    sio_hw->gpio_set = (data & 0x3F);
+    sio_hw->gpio_set = ((uint32_t)data << PIN_R0) & RGB_MASK;
 
     // Clock pulse - rising edge latches data into shift register
     sio_hw->gpio_set = CLK_MASK;
@@ -358,19 +2540,40 @@ static inline void __not_in_flash_func(shift_out_pixel)(uint8_t data) {
 // ============================================
 // HUB75 Refresh - CPU GPIO version
 // ============================================
+// The CPU cannot blank while it shifts, so only planes lit for at least
+// one row shift stay on during the next shift; shorter ones are blanked on
+// time and shifted serially, keeping the BCM weights exact.
+static uint32_t gpio_shift_cycles = 0;  // Last measured row shift (SysTick)
+static uint32_t gpio_oe_start = 0;      // SysTick at the last latch
+static uint32_t gpio_oe_cycles = 0;     // On-time of the latched row
+
 void __not_in_flash_func(hub75_refresh)() {
-    for (int bit = 0; bit < COLOR_DEPTH; bit++) {
-        uint32_t delay_us = 1 << bit;
+    // Pick up a newly converted frame only between full sweeps, then select
+    // this sweep's dither phase
+    const bcm_row_t* planes = bcm_take_front()[bcm_next_phase()];
+    int depth = bcm_buf_depth[bcm_front];
 
-        for (int row = 0; row < SCAN_ROWS; row++) {
-            // 1. Disable output (OE HIGH)
-            sio_hw->gpio_set = OE_MASK;
+    for (int bit = 0; bit < depth; bit++) {
+        uint32_t on_cycles = bcm_plane_cycles[bit];
+        bool overlap = on_cycles >= gpio_shift_cycles;
 
-            // 2. Shift out pixel data (right to left for chained panels)
-            uint8_t* row_data = bcm_planes[row][bit];
-            for (int x = DISPLAY_WIDTH - 1; x >= 0; x--) {
+        for (int row = 0; row < SCAN_ROWS; row++) {
+            // 1. Shift out pixel data (right to left for chained panels),
+            //    the previous row may still be lit
+            uint32_t start = systick_hw->cvr;
+            const bcm_px_t* row_data = planes[row][bit];
+            for (int x = SHIFT_WIDTH - 1; x >= 0; x--) {
                 shift_out_pixel(row_data[x]);
             }
+            gpio_shift_cycles = systick_elapsed(start);
+
+            // 2. Finish the previous row's on-time, then disable output (OE HIGH)
+            uint32_t wait_start = systick_hw->cvr;
+            while (systick_elapsed(gpio_oe_start) < gpio_oe_cycles) {
+                tight_loop_contents();
+            }
+            sio_hw->gpio_set = OE_MASK;
+            stats_idle_cycles += systick_elapsed(wait_start);
 
             // 3. Set row address
             set_row_address(row);
@@ -380,14 +2583,21 @@ void __not_in_flash_func(hub75_refresh)() {
             __asm volatile("nop\nnop\nnop\nnop");
             sio_hw->gpio_clr = LAT_MASK;
 
-            // 5. Enable output (OE LOW)
-            sio_hw->gpio_clr = OE_MASK;
-
-            // 6. BCM delay - display this bit plane
-            delayMicroseconds(delay_us);
+            // 5. Enable output (OE LOW) and start the BCM on-time
+            if (on_cycles) {
+                sio_hw->gpio_clr = OE_MASK;
+            }
+            gpio_oe_start = systick_hw->cvr;
+            gpio_oe_cycles = on_cycles;
 
-            // 7. Disable output before next row
-            sio_hw->gpio_set = OE_MASK;
+            // 6. Short planes: blank on time rather than during the next shift
+            if (!overlap) {
+                while (systick_elapsed(gpio_oe_start) < on_cycles) {
+                    tight_loop_contents();
+                }
+                sio_hw->gpio_set = OE_MASK;
+                stats_idle_cycles += systick_elapsed(gpio_oe_start);
+            }
         }
     }
 }
@@ -399,6 +2609,11 @@ void __not_in_flash_func(hub75_refresh)() {
 // ============================================
 void __not_in_flash_func(display_solid_color)(uint8_t color_mask, int duration_ms) {
     // color_mask: bit0=R0, bit1=G0, bit2=B0, bit3=R1, bit4=G1, bit5=B1
+    // (the same on every chain)
+    uint32_t rgb_bits = 0;
+    for (int chain = 0; chain < HUB75_CHAINS; chain++) {
+        rgb_bits |= (uint32_t)(color_mask & 0x3F) << (PIN_R0 + 6 * chain);
+    }
     uint32_t start = millis();
 
     while (millis() - start < (uint32_t)duration_ms) {
@@ -407,9 +2622,9 @@ void __not_in_flash_func(display_solid_color)(uint8_t color_mask, int duration_m
             sio_hw->gpio_set = OE_MASK;
 
             // 2. Shift out all pixels with the solid color (direct GPIO)
-            for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            for (int x = 0; x < SHIFT_WIDTH; x++) {
                 sio_hw->gpio_clr = RGB_MASK;
-                sio_hw->gpio_set = (color_mask & 0x3F);
+                sio_hw->gpio_set = rgb_bits;
 
                 sio_hw->gpio_set = CLK_MASK;
                 __asm volatile("nop\nnop\nnop\nnop");
@@ -467,11 +2682,14 @@ void setup1() {
     show_boot_screen();
     boot_complete = true;
 
+    // SysTick times the BCM on-times of the GPIO refresh and idle time (per core)
+    systick_start();
+
 #if HUB75_USE_PIO
-    // Now initialize PIO (takes over GP0-5 and GP6 from GPIO)
+    // Now initialize PIO (takes over the data, CLK and OE pins from GPIO)
     hub75_pio_init();
 
-    // Initialize DMA for PIO data transfer
+    // Initialize DMA for PIO data transfer (starts refresh in chain mode)
     hub75_dma_init();
 #endif
 }
@@ -482,50 +2700,340 @@ void loop1() {
     hub75_refresh();
 }
 
+#if HUB75_BENCHMARK
+// ============================================
+// BCM conversion benchmark (Core0, at boot)
+// ============================================
+// Counts CPU cycles with SysTick (24-bit, enough for one 128x64 frame) and
+// prints reference vs LUT kernel results over USB CDC. A dithered build
+// is not cross-checked: its phase sets differ from the reference planes.
+static uint32_t planes_checksum(const bcm_row_t* planes) {
+    const uint8_t* p = (const uint8_t*)planes;
+    uint32_t sum = 0;
+    for (size_t i = 0; i < sizeof(bcm_row_t) * SCAN_ROWS; i++) {
+        sum = (sum << 5) + sum + p[i];
+    }
+    return sum;
+}
+
+void run_convert_benchmark() {
+    // LUTs are built by Core1 before the boot screen
+    while (!boot_complete) {
+        delay(1);
+    }
+
+    // Pseudo-random test frame
+    uint32_t seed = 0x12345678;
+    for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        frame_buffer[i] = (uint16_t)(seed >> 16);
+    }
+
+    const int iterations = 8;
+    uint32_t ref_cycles = 0;
+    uint32_t lut_cycles = 0;
+    uint32_t ref_sum = 0;
+    uint32_t lut_sum = 0;
+
+    for (int i = 0; i < iterations; i++) {
+        bcm_row_t* back = bcm_planes[bcm_acquire_back()][0];
+        uint32_t start = systick_hw->cvr;
+        convert_to_bcm_reference(frame_buffer, back);
+        ref_cycles += systick_elapsed(start);
+        ref_sum = planes_checksum(back);
+
+        start = systick_hw->cvr;
+        convert_to_bcm(frame_buffer, BCM_ALL_ROWS);
+        lut_cycles += systick_elapsed(start);
+        while (bcm_swap_pending) {
+            tight_loop_contents();
+        }
+        lut_sum = planes_checksum(bcm_planes[bcm_front][0]);
+    }
+
+    // Paletted frame: same pixels reinterpreted as P8 indices
+    uint32_t p8_cycles = 0;
+    for (int i = 0; i < iterations; i++) {
+        uint32_t start = systick_hw->cvr;
+        convert_to_bcm_format(frame_buffer, PIXFMT_P8, BCM_ALL_ROWS);
+        p8_cycles += systick_elapsed(start);
+        while (bcm_swap_pending) {
+            tight_loop_contents();
+        }
+    }
+
+    Serial.printf("convert_to_bcm %dx%d: reference %lu cycles, lut %lu cycles (%s), p8 %lu cycles\n",
+                  DISPLAY_WIDTH, DISPLAY_HEIGHT,
+                  (unsigned long)(ref_cycles / iterations),
+                  (unsigned long)(lut_cycles / iterations),
+                  HUB75_DITHER_BITS ? "dithered" : ref_sum == lut_sum ? "match" : "MISMATCH",
+                  (unsigned long)(p8_cycles / iterations));
+
+    // Blank the panel again
+    memset(frame_buffer, 0, sizeof(frame_slots[0]));
+    convert_to_bcm(frame_buffer, BCM_ALL_ROWS);
+}
+#endif
+
+#if HUB75_SELFTEST
+// ============================================
+// Clock profile self-test (Core0, at boot)
+// ============================================
+// One-pixel red / green / blue / white columns change every data bit on
+// every clock, so shift errors at a too-fast profile show up as wrong
+// colours or smear. Refresh sweeps are counted for SELFTEST_MS at each
+// depth; the pattern stays up until the host sends a frame.
+#define SELFTEST_MS 500
+
+void run_clock_selftest() {
+    static const uint16_t stripes[4] = {0xF800, 0x07E0, 0x001F, 0xFFFF};
+
+    // Refresh runs once Core1 has finished the boot screen and PIO setup
+    while (!boot_complete) {
+        delay(1);
+    }
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            frame_buffer[y * DISPLAY_WIDTH + x] = stripes[x & 3];
+        }
+    }
+
+    static const int depths[4] = {4, 6, 8, 10};
+    uint32_t hz[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4 && depths[i] <= COLOR_DEPTH; i++) {
+        set_bcm_depth(depths[i]);
+        convert_to_bcm(frame_buffer, BCM_ALL_ROWS);
+        while (bcm_swap_pending) {
+            tight_loop_contents();
+        }
+        uint32_t sweeps = stats_sweeps;
+        uint32_t start = time_us_32();
+        delay(SELFTEST_MS);
+        uint32_t us = time_us_32() - start;
+        hz[i] = (uint32_t)((uint64_t)(stats_sweeps - sweeps) * 1000000u / us);
+    }
+    set_bcm_depth(COLOR_DEPTH);
+    convert_to_bcm(frame_buffer, BCM_ALL_ROWS);
+
+    // Give the host a moment to open the port
+    for (int i = 0; i < 3000 && !Serial; i++) {
+        delay(1);
+    }
+    uint32_t clk_khz = clock_get_hz(clk_sys) / 1000;
+#if HUB75_USE_PIO
+    uint32_t shift_khz = (uint32_t)(clk_khz / PIO_CLKDIV) / (2 * (PIO_CLK_DELAY + 1));
+    Serial.printf("clock profile %d: clk_sys %lu kHz (tuned for %d MHz), shift clock %lu kHz\n",
+                  HUB75_CLOCK_PROFILE, (unsigned long)clk_khz, PROFILE_SYS_MHZ,
+                  (unsigned long)shift_khz);
+#else
+    Serial.printf("clock profile %d: clk_sys %lu kHz, GPIO shift\n",
+                  HUB75_CLOCK_PROFILE, (unsigned long)clk_khz);
+#endif
+    for (int i = 0; i < 4 && depths[i] <= COLOR_DEPTH; i++) {
+        Serial.printf("  %2d-bit: %lu Hz refresh\n", depths[i], (unsigned long)hz[i]);
+    }
+#if HUB75_DITHER_BITS
+    Serial.printf("  dither: %d phases, one per sweep\n", BCM_PHASES);
+#endif
+}
+#endif
+
 // ============================================
 // Core0: USB CDC Reception + BCM Conversion
 // ============================================
+#if HUB75_USE_VENDOR
+// Vendor interface with WebUSB descriptors (no landing page)
+static Adafruit_USBD_WebUSB usb_vendor;
+#endif
+
 void setup() {
-    Serial.begin(115200);  // Baud ignored for USB CDC
+#if HUB75_USE_VENDOR
+    usb_vendor.begin();
+    // Re-enumerate if the core already brought up USB without the interface
+    if (TinyUSBDevice.mounted()) {
+        TinyUSBDevice.detach();
+        delay(10);
+        TinyUSBDevice.attach();
+    }
+#endif
 
-    memset(recv_buffer, 0, sizeof(recv_buffer));
+    Serial.begin(115200);  // Baud ignored for USB CDC
+    systick_start();       // Decoder / conversion cycle counts (PKT_STATS)
 
     delay(500);  // Wait for USB
+
+#if HUB75_BENCHMARK
+    run_convert_benchmark();
+#endif
+
+#if HUB75_SELFTEST
+    run_clock_selftest();
+#endif
+
+#if HUB75_USE_CLIPS
+    clip_autoplay();
+#endif
+}
+
+// ============================================
+// Replies to the host - credit reports and statistics
+// ============================================
+// Largest reply: PKT_STATS
+#define REPLY_MAX   (sizeof(pkt_header_t) + sizeof(pkt_stats_t))
+
+// Header + body, COBS-encoded and delimited (at most REPLY_MAX + 2 bytes)
+static size_t build_reply(uint8_t type, const void* body, size_t len, uint8_t* out) {
+    uint8_t pkt[REPLY_MAX];
+    pkt_header_t hdr = {PROTO_MAGIC, PROTO_VERSION, type, 0};
+    memcpy(pkt, &hdr, sizeof(hdr));
+    memcpy(pkt + sizeof(hdr), body, len);
+
+    // COBS: a reply is far shorter than one 254-byte block
+    size_t code_at = 0;
+    size_t n = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < sizeof(hdr) + len; i++) {
+        if (pkt[i] == 0x00) {
+            out[code_at] = code;
+            code_at = n++;
+            code = 1;
+        } else {
+            out[n++] = pkt[i];
+            code++;
+        }
+    }
+    out[code_at] = code;
+    out[n++] = 0x00;
+    return n;
+}
+
+// Write a reply on CDC or the vendor interface. Never blocks: returns false
+// if the IN FIFO has no room, leaving it to be retried after the next chunk.
+static bool send_reply(bool vendor, const uint8_t* buf, size_t n) {
+#if USE_TINYUSB
+#if HUB75_USE_VENDOR
+    if (vendor) {
+        if (tud_vendor_write_available() < n) {
+            return false;
+        }
+        tud_vendor_write(buf, n);
+        tud_vendor_write_flush();
+        return true;
+    }
+#endif
+    if (tud_cdc_write_available() < n) {
+        return false;
+    }
+    tud_cdc_write(buf, n);
+    tud_cdc_write_flush();
+    return true;
+#else
+    (void)vendor;
+    if (Serial.availableForWrite() < (int)n) {
+        return false;
+    }
+    Serial.write(buf, n);
+    return true;
+#endif
+}
+
+// PKT_CREDIT with the current count (9 bytes)
+static void send_credit(bool vendor) {
+    uint8_t buf[REPLY_MAX + 2];
+    pkt_credit_t credit = {rx_frames_done, FRAME_CREDITS};
+    if (send_reply(vendor, buf, build_reply(PKT_CREDIT, &credit, sizeof(credit), buf))) {
+        rx_credit_pending = false;
+    }
+}
+
+// PKT_STATS snapshot; the per-query maximum restarts once it is sent
+static void send_stats(bool vendor) {
+    pkt_stats_t st;
+    st.time_us = time_us_32();
+    st.rx_bytes = stats_rx_bytes;
+    st.packets = stats_packets;
+    st.dropped = stats_dropped;
+    st.cobs_errors = stats_cobs_errors;
+    st.frames = stats_frames;
+    st.flips = stats_flips;
+    st.sweeps = stats_sweeps;
+    st.decode_cycles = stats_decode_cycles;
+    st.convert_cycles = stats_convert_cycles;
+    st.convert_max_cycles = stats_convert_max;
+    st.idle_cycles = stats_idle_cycles;
+    st.clk_mhz = (uint16_t)(clock_get_hz(clk_sys) / 1000000);
+    st.depth = bcm_depth;
+    st.queued = conv_queued;
+
+    uint8_t buf[REPLY_MAX + 2];
+    if (send_reply(vendor, buf, build_reply(PKT_STATS, &st, sizeof(st), buf))) {
+        rx_stats_pending = false;
+        stats_convert_max = 0;
+    }
+}
+
+static void send_replies(bool vendor) {
+    if (rx_credit_pending) {
+        send_credit(vendor);
+    }
+    if (rx_stats_pending) {
+        send_stats(vendor);
+    }
+}
+
+// USB receive chunk (one CDC endpoint buffer)
+// Both transports feed the same decoder: a host should use one at a time
+static uint8_t rx_chunk[RX_CHUNK_SIZE] __attribute__((aligned(4)));
+static bool rx_vendor = false;          // Transport replies go back on
+
+// Host bytes through the decoder, counted for PKT_STATS. Conversion it has
+// to run when every slot is queued counts as conversion, not decoding.
+static void rx_feed_host(const uint8_t* data, size_t len, bool vendor) {
+    uint32_t start = systick_hw->cvr;
+    uint32_t converted = stats_convert_cycles;
+    rx_vendor = vendor;
+    rx_feed(data, len);
+    stats_decode_cycles += systick_elapsed(start) - (stats_convert_cycles - converted);
+    stats_rx_bytes += len;
 }
 
 void loop() {
     // Simplified frame reception (Reference: LED_Matrix_firmware_K00798)
-    // Process serial data and update display immediately when frame is complete
-    while (Serial.available()) {
-        uint8_t c = Serial.read();
-
-        if (c == 0x00) {
-            // Packet delimiter received - decode COBS packet
-            if (recv_pos > 0) {
-                // Decode COBS into temporary buffer
-                size_t decoded_len = cobs_decode(recv_buffer, recv_pos,
-                                                 decode_buffer, FRAME_SIZE_RGB565);
-
-                // Verify size matches expected frame size
-                if (decoded_len == FRAME_SIZE_RGB565) {
-                    // Valid frame - copy directly and convert immediately
-                    // This approach is simpler and more stable for video playback
-                    memcpy(frame_buffer, decode_buffer, FRAME_SIZE_RGB565);
-                    convert_to_bcm(frame_buffer);
-                }
-                // Invalid packets are silently discarded
-            }
-            // Reset for next packet
-            recv_pos = 0;
+    // Drain the CDC FIFO in endpoint-sized chunks; each packet is decoded in
+    // place and queued for conversion as soon as its delimiter arrives, and
+    // one band of the oldest queued frame is converted per chunk.
+    // Invalid packets are silently discarded; every frame packet is
+    // answered with a credit report (PKT_CREDIT), a stats query with PKT_STATS
+#if USE_TINYUSB
+    uint32_t n;
+    while ((n = tud_cdc_read(rx_chunk, sizeof(rx_chunk))) > 0) {
+        rx_feed_host(rx_chunk, n, false);
+        convert_step(CONVERT_BAND_ROWS);
+        send_replies(false);
+    }
+#else
+    int avail;
+    while ((avail = Serial.available()) > 0) {
+        size_t want = (size_t)avail < sizeof(rx_chunk) ? (size_t)avail : sizeof(rx_chunk);
+        rx_feed_host(rx_chunk, Serial.readBytes(rx_chunk, want), false);
+        convert_step(CONVERT_BAND_ROWS);
+        send_replies(false);
+    }
+#endif
 
-        } else {
-            // Accumulate COBS-encoded data
-            if (recv_pos < RECV_BUFFER_SIZE) {
-                recv_buffer[recv_pos++] = c;
-            } else {
-                // Buffer overflow - discard packet and reset
-                recv_pos = 0;
-            }
-        }
+#if HUB75_USE_VENDOR
+    while ((n = tud_vendor_read(rx_chunk, sizeof(rx_chunk))) > 0) {
+        rx_feed_host(rx_chunk, n, true);
+        convert_step(CONVERT_BAND_ROWS);
+        send_replies(true);
     }
+#endif
+
+    // Host quiet: keep converting queued frames
+    convert_step(CONVERT_BAND_ROWS);
+    send_replies(rx_vendor);
+
+#if HUB75_USE_CLIPS
+    clip_tick();
+#endif
 }
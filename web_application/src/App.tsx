@@ -1,21 +1,24 @@
 import React, { useState, useEffect, useRef } from 'react';
 import { SerialDevice } from './lib/serial';
+import { WebUSBDevice } from './lib/webusb';
 import { loadImage, VideoPlayer } from './lib/media';
 import { VideoProcessor } from './lib/videoProcessor';
 import { generateDemoFrame } from './lib/demos';
 import { DropZone } from './components/DropZone';
 import { DemoSelector } from './components/DemoSelector';
-import type { DemoType } from './types';
+import type { DemoType, LEDMatrixController } from './types';
 
 type Mode = 'idle' | 'image' | 'video' | 'demo';
+type Transport = 'serial' | 'webusb';
 
 function App() {
   const [connected, setConnected] = useState(false);
   const [mode, setMode] = useState<Mode>('idle');
   const [status, setStatus] = useState('');
   const [fps, setFps] = useState(0);
+  const [transport, setTransport] = useState<Transport>('serial');
 
-  const serialRef = useRef<SerialDevice>(new SerialDevice());
+  const deviceRef = useRef<LEDMatrixController>(new SerialDevice());
   const videoPlayerRef = useRef<VideoPlayer>(new VideoPlayer());
   const videoProcessorRef = useRef<VideoProcessor>(new VideoProcessor());
   const demoAnimationRef = useRef<number | null>(null);
@@ -25,7 +28,7 @@ function App() {
     return () => {
       stopCurrentMode();
       if (connected) {
-        serialRef.current.disconnect();
+        deviceRef.current.disconnect();
       }
     };
   }, []);
@@ -53,7 +56,8 @@ function App() {
 
   const handleConnect = async () => {
     try {
-      await serialRef.current.connect();
+      deviceRef.current = transport === 'webusb' ? new WebUSBDevice() : new SerialDevice();
+      await deviceRef.current.connect();
       setConnected(true);
       setStatus('接続成功');
     } catch (error) {
@@ -64,7 +68,7 @@ function App() {
 
   const handleDisconnect = async () => {
     stopCurrentMode();
-    await serialRef.current.disconnect();
+    await deviceRef.current.disconnect();
     setConnected(false);
     setStatus('切断しました');
     setFps(0);
@@ -84,7 +88,7 @@ function App() {
         const imageData = await loadImage(file);
         setStatus('画像を表示中');
         setMode('image');
-        await serialRef.current.sendFrame(imageData);
+        await deviceRef.current.sendFrame(imageData);
         updateFps();
       } catch (error) {
         setStatus(`画像の読み込みに失敗: ${error}`);
@@ -104,10 +108,12 @@ function App() {
         await videoPlayerRef.current.load(processedBlob);
         setStatus('動画を再生中');
         setMode('video');
-        videoPlayerRef.current.play(async (imageData) => {
-          await serialRef.current.sendFrame(imageData);
+        // Paced devices get the video's own rate; sendFrame drops frames
+        // while no credit is free
+        videoPlayerRef.current.play(async (frame) => {
+          await deviceRef.current.sendFrame(frame);
           updateFps();
-        });
+        }, () => deviceRef.current.isPaced());
       } catch (error) {
         setStatus(`動画の読み込みに失敗: ${error}`);
       }
@@ -128,7 +134,7 @@ function App() {
     const runDemo = async () => {
       const t = (Date.now() - startTime) / 1000;
       const imageData = generateDemoFrame(demo, t);
-      await serialRef.current.sendFrame(imageData);
+      await deviceRef.current.sendFrame(imageData);
       updateFps();
       demoAnimationRef.current = requestAnimationFrame(runDemo);
     };
@@ -167,12 +173,22 @@ function App() {
                 </div>
               )}
               {!connected ? (
-                <button
-                  onClick={handleConnect}
-                  className="px-6 py-2 bg-blue-500 text-white rounded-lg hover:bg-blue-600 transition-colors font-semibold"
-                >
-                  接続
-                </button>
+                <>
+                  <select
+                    value={transport}
+                    onChange={(e) => setTransport(e.target.value as Transport)}
+                    className="px-3 py-2 border border-gray-300 rounded-lg text-sm text-gray-700"
+                  >
+                    <option value="serial">Web Serial</option>
+                    <option value="webusb">WebUSB</option>
+                  </select>
+                  <button
+                    onClick={handleConnect}
+                    className="px-6 py-2 bg-blue-500 text-white rounded-lg hover:bg-blue-600 transition-colors font-semibold"
+                  >
+                    接続
+                  </button>
+                </>
               ) : (
                 <>
                   {mode !== 'idle' && (
@@ -217,7 +233,7 @@ function App() {
         <footer className="mt-8 text-center text-sm text-gray-500">
           <p>128x32 HUB75 LED Matrix Controller</p>
           <p className="mt-1">
-            Web Serial APIを使用 - Chrome/Edge推奨
+            Web Serial / WebUSB APIを使用 - Chrome/Edge推奨
           </p>
         </footer>
       </div>
@@ -1,3 +1,10 @@
+/**
+ * Largest COBS encoding of `length` bytes (without the 0x00 terminator)
+ */
+export function cobsMaxSize(length: number): number {
+  return length + Math.floor(length / 254) + 1;
+}
+
 /**
  * COBS (Consistent Overhead Byte Stuffing) Encoder
  *
@@ -5,40 +12,79 @@
  * The packet is terminated with a zero byte.
  */
 export function cobsEncode(data: Uint8Array): Uint8Array {
-  if (data.length === 0) {
-    return new Uint8Array([0x01]);
-  }
+  const out = new Uint8Array(cobsMaxSize(data.length));
+  return out.slice(0, cobsEncodeInto(data, out));
+}
 
-  const output: number[] = [];
-  let codeIndex = 0;
+/**
+ * COBS-encode into a preallocated buffer (same output as cobsEncode)
+ *
+ * `out` needs cobsMaxSize(data.length) bytes from `offset`.
+ * Returns the encoded length.
+ */
+export function cobsEncodeInto(data: Uint8Array, out: Uint8Array, offset: number = 0): number {
+  let n = offset;
+  let codeIndex = n++; // Placeholder for first code
   let code = 1;
 
-  output.push(0); // Placeholder for first code
-
-  for (const byte of data) {
+  for (let i = 0; i < data.length; i++) {
+    const byte = data[i]!;
     if (byte === 0) {
       // Found zero - write code and start new segment
-      output[codeIndex] = code;
-      codeIndex = output.length;
-      output.push(0); // Placeholder for next code
+      out[codeIndex] = code;
+      codeIndex = n++;
       code = 1;
     } else {
       // Copy non-zero byte
-      output.push(byte);
+      out[n++] = byte;
       code += 1;
 
       if (code === 0xFF) {
         // Segment full (254 bytes) - write code and start new segment
-        output[codeIndex] = code;
-        codeIndex = output.length;
-        output.push(0); // Placeholder for next code
+        out[codeIndex] = code;
+        codeIndex = n++;
         code = 1;
       }
     }
   }
 
   // Write final code
-  output[codeIndex] = code;
+  out[codeIndex] = code;
+
+  return n - offset;
+}
+
+/**
+ * COBS Decoder
+ *
+ * Decodes one packet (without the terminating zero byte) into `out`, which
+ * needs data.length bytes; returns a view of `out`.
+ * Returns null if the packet is malformed.
+ */
+export function cobsDecode(
+  data: Uint8Array,
+  out: Uint8Array = new Uint8Array(data.length)
+): Uint8Array | null {
+  let n = 0;
+  let i = 0;
+
+  while (i < data.length) {
+    const code = data[i]!;
+    if (code === 0) {
+      return null;
+    }
+    i++;
+    const end = i + code - 1;
+    if (end > data.length) {
+      return null;
+    }
+    out.set(data.subarray(i, end), n);
+    n += end - i;
+    i = end;
+    if (code !== 0xFF && i < data.length) {
+      out[n++] = 0;
+    }
+  }
 
-  return new Uint8Array(output);
+  return out.subarray(0, n);
 }
@@ -0,0 +1,85 @@
+import { cobsEncodeInto, cobsMaxSize } from './cobs';
+import { rgbaToRGB565, drawFlipped } from './frame';
+import { FrameDeltaEncoder } from './protocol';
+import { DISPLAY_WIDTH, DISPLAY_HEIGHT } from '../types';
+import type { EncoderRequest, EncoderReply } from './frameEncoder';
+
+/**
+ * Frame encoder worker
+ *
+ * Turns frames into COBS packets off the main thread: letterbox and flip
+ * on an OffscreenCanvas, RGB565 packing into reused frames, delta coding
+ * and COBS encoding into pooled buffers. Each packet's buffer is
+ * transferred to the page and comes back with a 'release' message once
+ * it has been written.
+ */
+
+// Largest frame packet: header, raw pixels and the pad byte
+const PACKET_MAX = cobsMaxSize(4 + DISPLAY_WIDTH * DISPLAY_HEIGHT * 2 + 1) + 1;
+
+const canvas = new OffscreenCanvas(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+const ctx = canvas.getContext('2d', { willReadFrequently: true })!;
+const encoder = new FrameDeltaEncoder();
+
+// Two frames in turn: the encoder keeps the previous one for the delta
+const frames = [
+  new Uint16Array(DISPLAY_WIDTH * DISPLAY_HEIGHT),
+  new Uint16Array(DISPLAY_WIDTH * DISPLAY_HEIGHT),
+];
+let nextFrame = 0;
+
+// Packet buffers not currently held by the page
+const pool: ArrayBuffer[] = [];
+
+function packFrame(request: Extract<EncoderRequest, { type: 'encode' }>): Uint16Array {
+  const frame = frames[nextFrame]!;
+  nextFrame ^= 1;
+
+  const { source } = request;
+  if (source instanceof ImageBitmap) {
+    drawFlipped(ctx, source, source.width, source.height);
+    source.close();
+    rgbaToRGB565(ctx.getImageData(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT).data, frame, false);
+  } else if (source.width === DISPLAY_WIDTH && source.height === DISPLAY_HEIGHT) {
+    // Already display-sized: flip while packing
+    rgbaToRGB565(source.data, frame, true);
+  } else {
+    const scratch = new OffscreenCanvas(source.width, source.height);
+    scratch.getContext('2d')!.putImageData(source, 0, 0);
+    drawFlipped(ctx, scratch, source.width, source.height);
+    rgbaToRGB565(ctx.getImageData(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT).data, frame, false);
+  }
+  return frame;
+}
+
+function reply(message: EncoderReply, transfer: Transferable[] = []): void {
+  self.postMessage(message, { transfer });
+}
+
+self.onmessage = (event: MessageEvent<EncoderRequest>) => {
+  const request = event.data;
+  switch (request.type) {
+    case 'reset':
+      encoder.reset();
+      break;
+
+    case 'release':
+      pool.push(request.buffer);
+      break;
+
+    case 'encode': {
+      const update = encoder.encode(packFrame(request));
+      if (update === null) {
+        reply({ type: 'unchanged', id: request.id });
+        break;
+      }
+
+      const buffer = pool.pop() ?? new ArrayBuffer(PACKET_MAX);
+      const out = new Uint8Array(buffer);
+      const length = cobsEncodeInto(update, out);
+      out[length] = 0x00;
+      reply({ type: 'packet', id: request.id, buffer, length: length + 1 }, [buffer]);
+      break;
+    }
+  }
+};
@@ -0,0 +1,62 @@
+import { cobsEncode } from './cobs';
+import { DISPLAY_WIDTH, DISPLAY_HEIGHT } from '../types';
+
+/**
+ * Anything the frame encoder accepts: canvas pixels or a decoded bitmap
+ * (video frames, see VideoPlayer)
+ */
+export type FrameSource = ImageData | ImageBitmap;
+
+/**
+ * Convert RGBA pixels to RGB565 in a preallocated frame
+ *
+ * With `mirror` each row is written right to left (HUB75 shift order).
+ */
+export function rgbaToRGB565(
+  data: Uint8ClampedArray,
+  out: Uint16Array,
+  mirror: boolean
+): void {
+  for (let y = 0; y < DISPLAY_HEIGHT; y++) {
+    const row = y * DISPLAY_WIDTH;
+    for (let x = 0; x < DISPLAY_WIDTH; x++) {
+      const i = (row + x) * 4;
+      const r = data[i]! >> 3;     // 8-bit to 5-bit
+      const g = data[i + 1]! >> 2; // 8-bit to 6-bit
+      const b = data[i + 2]! >> 3; // 8-bit to 5-bit
+
+      out[row + (mirror ? DISPLAY_WIDTH - 1 - x : x)] = (r << 11) | (g << 5) | b;
+    }
+  }
+}
+
+/**
+ * Draw a source letterboxed and horizontally flipped (HUB75 shift register
+ * order) onto a display-sized canvas
+ */
+export function drawFlipped(
+  ctx: OffscreenCanvasRenderingContext2D,
+  source: CanvasImageSource,
+  width: number,
+  height: number
+): void {
+  const scale = Math.min(DISPLAY_WIDTH / width, DISPLAY_HEIGHT / height);
+  const w = width * scale;
+  const h = height * scale;
+
+  ctx.setTransform(-1, 0, 0, 1, DISPLAY_WIDTH, 0);
+  ctx.fillStyle = 'black';
+  ctx.fillRect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+  ctx.drawImage(source, (DISPLAY_WIDTH - w) / 2, (DISPLAY_HEIGHT - h) / 2, w, h);
+}
+
+/**
+ * COBS-encode a packet and append the 0x00 delimiter
+ */
+export function framePacket(data: Uint8Array): Uint8Array {
+  const encoded = cobsEncode(data);
+  const packet = new Uint8Array(encoded.length + 1);
+  packet.set(encoded, 0);
+  packet[encoded.length] = 0x00;
+  return packet;
+}
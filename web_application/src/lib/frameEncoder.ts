@@ -0,0 +1,87 @@
+import type { FrameSource } from './frame';
+
+/**
+ * Messages to the encoder worker (see encoder.worker.ts)
+ */
+export type EncoderRequest =
+  | { type: 'encode'; id: number; source: FrameSource }
+  | { type: 'release'; buffer: ArrayBuffer }
+  | { type: 'reset' };
+
+/**
+ * Messages from the encoder worker: a COBS packet with its 0x00
+ * terminator in buffer[0, length), or no change since the last frame
+ */
+export type EncoderReply =
+  | { type: 'packet'; id: number; buffer: ArrayBuffer; length: number }
+  | { type: 'unchanged'; id: number };
+
+/**
+ * Page side of the frame encoder worker
+ *
+ * Frames are transferred to the worker (ImageBitmaps and ImageData
+ * buffers are not copied); their packets come back in transferred
+ * buffers that must be handed back with release() after writing, so the
+ * worker reuses them instead of allocating.
+ */
+export class FrameEncoder {
+  private worker = new Worker(new URL('./encoder.worker.ts', import.meta.url), {
+    type: 'module',
+  });
+  private nextId = 0;
+  private waiting = new Map<number, (packet: Uint8Array | null) => void>();
+
+  constructor() {
+    this.worker.onmessage = (event: MessageEvent<EncoderReply>) => {
+      const message = event.data;
+      const resolve = this.waiting.get(message.id);
+      this.waiting.delete(message.id);
+      if (message.type === 'packet') {
+        resolve?.(new Uint8Array(message.buffer, 0, message.length));
+      } else {
+        resolve?.(null);
+      }
+    };
+  }
+
+  /**
+   * Encode a frame as the smallest update since the last one
+   *
+   * The source is transferred and unusable afterwards. Resolves to the
+   * packet to send, or null if the frame is unchanged.
+   */
+  encode(source: FrameSource): Promise<Uint8Array | null> {
+    const id = this.nextId++;
+    const transfer = source instanceof ImageBitmap ? [source] : [source.data.buffer];
+    const request: EncoderRequest = { type: 'encode', id, source };
+    return new Promise((resolve) => {
+      this.waiting.set(id, resolve);
+      this.worker.postMessage(request, transfer);
+    });
+  }
+
+  /**
+   * Give a packet's buffer back to the worker once it has been written
+   */
+  release(packet: Uint8Array): void {
+    const request: EncoderRequest = { type: 'release', buffer: packet.buffer as ArrayBuffer };
+    this.worker.postMessage(request, [packet.buffer]);
+  }
+
+  /**
+   * Forget the device state; the next frame is sent in full
+   */
+  reset(): void {
+    const request: EncoderRequest = { type: 'reset' };
+    this.worker.postMessage(request);
+  }
+
+  /**
+   * Free a frame that will not be encoded (dropped)
+   */
+  static discard(source: FrameSource): void {
+    if (source instanceof ImageBitmap) {
+      source.close();
+    }
+  }
+}
@@ -1,6 +1,7 @@
 import { DISPLAY_WIDTH, DISPLAY_HEIGHT } from '../types';
+import type { FrameSource } from './frame';
 
-// Maximum FPS for video playback (internal limit)
+// Maximum FPS for video playback on devices without credit flow control
 const MAX_VIDEO_FPS = 18;
 
 /**
@@ -39,31 +40,30 @@ export async function loadImage(file: File): Promise<ImageData> {
 /**
  * Video player for HUB75 display
  * With simple frame rate control for stable serial transmission
- * Maximum frame rate is limited to MAX_VIDEO_FPS (15fps)
+ * When the device paces frames with credits (see FrameCredits), every video
+ * frame is handed out and sendFrame drops what the device cannot take;
+ * otherwise the frame rate is limited to MAX_VIDEO_FPS (18fps)
+ *
+ * Frames are handed out as ImageBitmaps at the video's own size; scaling
+ * and pixel readback happen in the encoder worker (see FrameEncoder).
  */
 export class VideoPlayer {
   private video: HTMLVideoElement;
-  private canvas: HTMLCanvasElement;
-  private ctx: CanvasRenderingContext2D;
   private animationId: number | null = null;
-  private onFrame: ((imageData: ImageData) => void) | null = null;
+  private onFrame: ((frame: FrameSource) => void) | null = null;
+  private isPaced: () => boolean = () => false;
   private lastFrameTime: number = 0;
-  private targetFps: number = MAX_VIDEO_FPS; // Target fps limited to MAX_VIDEO_FPS (15fps)
+  private targetFps: number = MAX_VIDEO_FPS; // Target fps when unpaced, at most MAX_VIDEO_FPS (18fps)
 
   constructor() {
     this.video = document.createElement('video');
     this.video.muted = true;
     this.video.loop = true;
-
-    this.canvas = document.createElement('canvas');
-    this.canvas.width = DISPLAY_WIDTH;
-    this.canvas.height = DISPLAY_HEIGHT;
-    this.ctx = this.canvas.getContext('2d')!;
   }
 
   /**
-   * Set target frame rate (fps)
-   * Maximum is limited to MAX_VIDEO_FPS (15fps)
+   * Set target frame rate (fps) for devices without credit flow control
+   * Maximum is limited to MAX_VIDEO_FPS (18fps)
    */
   setTargetFps(fps: number): void {
     this.targetFps = Math.max(1, Math.min(MAX_VIDEO_FPS, fps));
@@ -76,21 +76,32 @@ export class VideoPlayer {
       this.video.onerror = reject;
     });
     // Reset target FPS to maximum allowed (18fps)
-    // Video playback will be limited to this rate
+    // Unpaced playback will be limited to this rate
     this.targetFps = MAX_VIDEO_FPS;
   }
 
-  play(onFrame: (imageData: ImageData) => void): void {
+  /**
+   * Start playback
+   * `isPaced` is checked on every frame (the device's first credit report
+   * may arrive after playback started); while true, frames follow the
+   * video's own rate instead of the target fps.
+   */
+  play(onFrame: (frame: FrameSource) => void, isPaced: () => boolean = () => false): void {
     this.onFrame = onFrame;
+    this.isPaced = isPaced;
     this.lastFrameTime = 0;
     this.video.play();
-    this.animationId = requestAnimationFrame(this.renderLoop);
+    this.scheduleFrame();
   }
 
   pause(): void {
     this.video.pause();
     if (this.animationId !== null) {
-      cancelAnimationFrame(this.animationId);
+      if ('cancelVideoFrameCallback' in this.video) {
+        this.video.cancelVideoFrameCallback(this.animationId);
+      } else {
+        cancelAnimationFrame(this.animationId);
+      }
       this.animationId = null;
     }
   }
@@ -101,37 +112,42 @@ export class VideoPlayer {
     this.onFrame = null;
   }
 
+  /**
+   * Run renderLoop for the next video frame (display frame if the browser
+   * has no video frame callbacks)
+   */
+  private scheduleFrame(): void {
+    if ('requestVideoFrameCallback' in this.video) {
+      this.animationId = this.video.requestVideoFrameCallback(this.renderLoop);
+    } else {
+      this.animationId = requestAnimationFrame(this.renderLoop);
+    }
+  }
+
   private renderLoop = (timestamp: number): void => {
     if (!this.onFrame || this.video.paused || this.video.ended) {
       return;
     }
 
-    // Simple frame rate limiting
-    const frameInterval = 1000 / this.targetFps;
+    // Paced devices take every frame they have credit for; otherwise
+    // simple frame rate limiting
+    const frameInterval = this.isPaced() ? 0 : 1000 / this.targetFps;
     const elapsed = timestamp - this.lastFrameTime;
 
     if (elapsed >= frameInterval) {
-      this.lastFrameTime = timestamp - (elapsed % frameInterval);
-
-      // Draw video frame to canvas
-      const scale = Math.min(
-        DISPLAY_WIDTH / this.video.videoWidth,
-        DISPLAY_HEIGHT / this.video.videoHeight
-      );
-      const w = this.video.videoWidth * scale;
-      const h = this.video.videoHeight * scale;
-      const x = (DISPLAY_WIDTH - w) / 2;
-      const y = (DISPLAY_HEIGHT - h) / 2;
-
-      this.ctx.fillStyle = 'black';
-      this.ctx.fillRect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
-      this.ctx.drawImage(this.video, x, y, w, h);
-
-      const imageData = this.ctx.getImageData(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
-      this.onFrame(imageData);
+      this.lastFrameTime = frameInterval > 0 ? timestamp - (elapsed % frameInterval) : timestamp;
+
+      // Grab the current frame without reading pixels back on this thread
+      void createImageBitmap(this.video).then((bitmap) => {
+        if (this.onFrame) {
+          this.onFrame(bitmap);
+        } else {
+          bitmap.close(); // Stopped meanwhile
+        }
+      });
     }
 
-    this.animationId = requestAnimationFrame(this.renderLoop);
+    this.scheduleFrame();
   };
 
   isPlaying(): boolean {
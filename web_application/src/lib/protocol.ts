@@ -0,0 +1,370 @@
+import { cobsDecode } from './cobs';
+import { DISPLAY_WIDTH, DISPLAY_HEIGHT } from '../types';
+
+/**
+ * HUB75 host protocol (see firmware/include/hub75_protocol.h)
+ *
+ * A decoded packet is either a legacy raw RGB565 frame or a versioned
+ * packet: [magic][version][type][flags] followed by a type-specific body.
+ * All multi-byte fields are little-endian.
+ */
+export const PROTO_MAGIC = 0xA5;
+export const PROTO_VERSION = 1;
+
+export const PKT_FRAME_FULL = 0x01; // Body: full RGB565 frame
+export const PKT_FRAME_ROWS = 0x02; // Body: y, height (u16) + rows of pixels
+export const PKT_FRAME_RECT = 0x03; // Body: x, y, width, height (u16) + pixels
+export const PKT_CREDIT = 0x08; // Body: frames (u16), window (u8); also sent by the device
+
+// Frame packets only: run-length coded pixel data (see rleEncode)
+export const PKT_FLAG_RLE = 0x10;
+
+const HEADER_SIZE = 4;
+const FRAME_SIZE = DISPLAY_WIDTH * DISPLAY_HEIGHT * 2;
+
+// Send a full frame at least this often, even when deltas would be smaller
+const KEYFRAME_INTERVAL = 60;
+
+// Milliseconds without a credit report before frames in flight count as consumed
+const CREDIT_TIMEOUT_MS = 500;
+
+// Largest COBS-encoded packet from the device kept by FrameCredits (the
+// credit report is 9 bytes; longer packets are skipped)
+const RX_PACKET_MAX = 64;
+
+/**
+ * Allocate a packet with header and u16 body fields filled in
+ */
+function createPacket(type: number, fields: number[], pixelCount: number): {
+  packet: Uint8Array;
+  view: DataView;
+  offset: number;
+} {
+  let size = HEADER_SIZE + fields.length * 2 + pixelCount * 2;
+  // Versioned packets must not look like a raw frame: add one pad byte
+  if (size === FRAME_SIZE) {
+    size += 1;
+  }
+
+  const packet = new Uint8Array(size);
+  const view = new DataView(packet.buffer);
+  packet[0] = PROTO_MAGIC;
+  packet[1] = PROTO_VERSION;
+  packet[2] = type;
+  packet[3] = 0;
+
+  let offset = HEADER_SIZE;
+  for (const field of fields) {
+    view.setUint16(offset, field, true);
+    offset += 2;
+  }
+  return { packet, view, offset };
+}
+
+/**
+ * Full frame packet from RGB565 pixels (row-major)
+ */
+export function buildFullFrame(frame: Uint16Array): Uint8Array {
+  const { packet, view, offset } = createPacket(PKT_FRAME_FULL, [], frame.length);
+  for (let i = 0; i < frame.length; i++) {
+    view.setUint16(offset + i * 2, frame[i]!, true);
+  }
+  return packet;
+}
+
+/**
+ * Row range packet for rows [y, y + height)
+ */
+export function buildRows(frame: Uint16Array, y: number, height: number): Uint8Array {
+  const count = height * DISPLAY_WIDTH;
+  const { packet, view, offset } = createPacket(PKT_FRAME_ROWS, [y, height], count);
+  const start = y * DISPLAY_WIDTH;
+  for (let i = 0; i < count; i++) {
+    view.setUint16(offset + i * 2, frame[start + i]!, true);
+  }
+  return packet;
+}
+
+/**
+ * Rectangle packet for pixels [x, x + width) x [y, y + height)
+ */
+export function buildRect(
+  frame: Uint16Array,
+  x: number,
+  y: number,
+  width: number,
+  height: number
+): Uint8Array {
+  const fields = [x, y, width, height];
+  const { packet, view } = createPacket(PKT_FRAME_RECT, fields, width * height);
+  let offset = HEADER_SIZE + fields.length * 2;
+  for (let row = y; row < y + height; row++) {
+    for (let col = x; col < x + width; col++) {
+      view.setUint16(offset, frame[row * DISPLAY_WIDTH + col]!, true);
+      offset += 2;
+    }
+  }
+  return packet;
+}
+
+/**
+ * Run-length code RGB565 pixels for PKT_FLAG_RLE
+ *
+ * Each run is a control byte c followed by c + 1 literal pixels (c < 0x80)
+ * or by one pixel repeated c - 0x7E times (c >= 0x80, 2-129 repeats).
+ */
+export function rleEncode(pixels: Uint16Array): Uint8Array {
+  // Worst case: one control byte per 128 literal pixels
+  const out = new Uint8Array(pixels.length * 2 + Math.ceil(pixels.length / 128));
+  let n = 0;
+  let literalStart = 0;
+
+  const flushLiteral = (end: number) => {
+    for (let first = literalStart; first < end; first += 128) {
+      const last = Math.min(first + 128, end);
+      out[n++] = last - first - 1;
+      for (let i = first; i < last; i++) {
+        out[n++] = pixels[i]! & 0xFF;
+        out[n++] = pixels[i]! >> 8;
+      }
+    }
+  };
+
+  let i = 0;
+  while (i < pixels.length) {
+    let run = 1;
+    while (i + run < pixels.length && run < 129 && pixels[i + run] === pixels[i]) {
+      run++;
+    }
+    if (run < 2) {
+      i++;
+      continue;
+    }
+    flushLiteral(i);
+    out[n++] = 0x7E + run;
+    out[n++] = pixels[i]! & 0xFF;
+    out[n++] = pixels[i]! >> 8;
+    i += run;
+    literalStart = i;
+  }
+  flushLiteral(pixels.length);
+  return out.subarray(0, n);
+}
+
+/**
+ * Replace a frame packet's pixel data with its run-length coding if that
+ * is smaller. fieldBytes is the size of the body fields before the pixels.
+ */
+function compressPacket(packet: Uint8Array, fieldBytes: number, pixelCount: number): Uint8Array {
+  const offset = HEADER_SIZE + fieldBytes;
+  const pixels = new Uint16Array(pixelCount);
+  const view = new DataView(packet.buffer, packet.byteOffset + offset, pixelCount * 2);
+  for (let i = 0; i < pixelCount; i++) {
+    pixels[i] = view.getUint16(i * 2, true);
+  }
+  const coded = rleEncode(pixels);
+  if (coded.length >= pixelCount * 2) {
+    return packet;
+  }
+
+  let size = offset + coded.length;
+  // Versioned packets must not look like a raw frame: add one pad byte
+  if (size === FRAME_SIZE) {
+    size += 1;
+  }
+  const out = new Uint8Array(size);
+  out.set(packet.subarray(0, offset), 0);
+  out[3] = packet[3]! | PKT_FLAG_RLE;
+  out.set(coded, offset);
+  return out;
+}
+
+/**
+ * Flow control packet: sets the device's count of consumed frame packets.
+ * The device answers with its own PKT_CREDIT, so this doubles as a probe.
+ */
+export function buildCredit(frames: number = 0): Uint8Array {
+  // frames (u16), window (u8, ignored by the device)
+  return new Uint8Array([
+    PROTO_MAGIC, PROTO_VERSION, PKT_CREDIT, 0, frames & 0xFF, (frames >> 8) & 0xFF, 0,
+  ]);
+}
+
+/**
+ * Host side of PKT_CREDIT flow control
+ *
+ * Counts frame packets sent against the device's reports of frame packets
+ * consumed and allows at most `window` in flight. Until a device has
+ * reported (old firmware) sending is never held back.
+ */
+export class FrameCredits {
+  private window = 0;
+  private sent = 0;
+  private done = 0;
+  private pending = new Uint8Array(RX_PACKET_MAX); // Partial packet (COBS)
+  private pendingLength = 0; // -1 while skipping a packet too long to keep
+  private decoded = new Uint8Array(RX_PACKET_MAX);
+  private lastProgress = Date.now();
+
+  /**
+   * Forget the device state (when sending buildCredit(0))
+   */
+  reset(): void {
+    this.window = 0;
+    this.sent = 0;
+    this.done = 0;
+    this.pendingLength = 0;
+    this.lastProgress = Date.now();
+  }
+
+  /**
+   * True once the device has reported a window
+   */
+  isEnabled(): boolean {
+    return this.window > 0;
+  }
+
+  /**
+   * Process bytes received from the device (any chunking)
+   */
+  feed(data: Uint8Array): void {
+    let start = 0;
+    while (start < data.length) {
+      // Bytes up to the next delimiter (or the end of the chunk) go to pending
+      const delimiter = data.indexOf(0, start);
+      const end = delimiter < 0 ? data.length : delimiter;
+      if (this.pendingLength >= 0) {
+        if (this.pendingLength + end - start <= this.pending.length) {
+          this.pending.set(data.subarray(start, end), this.pendingLength);
+          this.pendingLength += end - start;
+        } else {
+          this.pendingLength = -1;
+        }
+      }
+      if (delimiter < 0) {
+        break;
+      }
+      start = delimiter + 1;
+
+      const packet = this.pendingLength > 0
+        ? cobsDecode(this.pending.subarray(0, this.pendingLength), this.decoded)
+        : null;
+      this.pendingLength = 0;
+      if (
+        packet !== null &&
+        packet.length >= HEADER_SIZE + 3 &&
+        packet[0] === PROTO_MAGIC &&
+        packet[1] === PROTO_VERSION &&
+        packet[2] === PKT_CREDIT
+      ) {
+        this.done = packet[4]! | (packet[5]! << 8);
+        this.window = packet[6]!;
+        this.lastProgress = Date.now();
+      }
+    }
+  }
+
+  /**
+   * True if another frame packet may be sent now
+   */
+  canSend(): boolean {
+    return this.window === 0 || this.inFlight() < this.window;
+  }
+
+  /**
+   * True if frames are held back and no report came within the timeout
+   *
+   * A report was lost or the device dropped a frame packet; the counts went
+   * out of step and the caller re-syncs with a credit probe (reset(), then
+   * send buildCredit(0)).
+   */
+  isStalled(): boolean {
+    return !this.canSend() && Date.now() - this.lastProgress > CREDIT_TIMEOUT_MS;
+  }
+
+  private inFlight(): number {
+    return (this.sent - this.done) & 0xFFFF;
+  }
+
+  /**
+   * Count one frame packet handed to the device
+   */
+  onSent(): void {
+    if (this.sent === this.done) {
+      this.lastProgress = Date.now();
+    }
+    this.sent = (this.sent + 1) & 0xFFFF;
+  }
+}
+
+/**
+ * Encodes each frame as the smallest update relative to the last one sent
+ */
+export class FrameDeltaEncoder {
+  private last: Uint16Array | null = null;
+  private framesSinceKey = 0;
+
+  /**
+   * @param compress - Run-length code packets when that makes them smaller
+   */
+  constructor(private compress: boolean = true) {}
+
+  /**
+   * Forget the device state; the next frame is sent in full
+   */
+  reset(): void {
+    this.last = null;
+  }
+
+  /**
+   * Returns the packet to send (not COBS-encoded), or null if unchanged
+   */
+  encode(frame: Uint16Array): Uint8Array | null {
+    const previous = this.last;
+    this.last = frame;
+
+    this.framesSinceKey++;
+    if (previous === null || this.framesSinceKey >= KEYFRAME_INTERVAL) {
+      this.framesSinceKey = 0;
+      return this.finish(buildFullFrame(frame), 0, frame.length);
+    }
+
+    // Bounding box of changed pixels
+    let x0 = DISPLAY_WIDTH;
+    let x1 = -1;
+    let y0 = DISPLAY_HEIGHT;
+    let y1 = -1;
+    for (let y = 0; y < DISPLAY_HEIGHT; y++) {
+      const base = y * DISPLAY_WIDTH;
+      for (let x = 0; x < DISPLAY_WIDTH; x++) {
+        if (frame[base + x] !== previous[base + x]) {
+          if (x < x0) x0 = x;
+          if (x > x1) x1 = x;
+          if (y < y0) y0 = y;
+          y1 = y;
+        }
+      }
+    }
+
+    if (y1 < 0) {
+      return null;
+    }
+
+    const width = x1 - x0 + 1;
+    const height = y1 - y0 + 1;
+    const rowsSize = 4 + height * DISPLAY_WIDTH * 2;
+    const rectSize = 8 + width * height * 2;
+
+    if (rectSize < rowsSize && rectSize < FRAME_SIZE) {
+      return this.finish(buildRect(frame, x0, y0, width, height), 8, width * height);
+    }
+    if (rowsSize < FRAME_SIZE) {
+      return this.finish(buildRows(frame, y0, height), 4, height * DISPLAY_WIDTH);
+    }
+    return this.finish(buildFullFrame(frame), 0, frame.length);
+  }
+
+  private finish(packet: Uint8Array, fieldBytes: number, pixelCount: number): Uint8Array {
+    return this.compress ? compressPacket(packet, fieldBytes, pixelCount) : packet;
+  }
+}
@@ -1,14 +1,18 @@
-import { cobsEncode } from './cobs';
-import { DISPLAY_WIDTH, DISPLAY_HEIGHT } from '../types';
+import { framePacket, type FrameSource } from './frame';
+import { FrameEncoder } from './frameEncoder';
+import { FrameCredits, buildCredit } from './protocol';
+import type { LEDMatrixController } from '../types';
 
 /**
  * Web Serial API wrapper for HUB75 LED Matrix communication
  */
-export class SerialDevice {
+export class SerialDevice implements LEDMatrixController {
   private port: SerialPort | null = null;
   private writer: WritableStreamDefaultWriter<Uint8Array> | null = null;
   private reader: ReadableStreamDefaultReader<Uint8Array> | null = null;
   private sending: boolean = false;
+  private encoder = new FrameEncoder();
+  private credits = new FrameCredits();
 
   async connect(baudRate: number = 115200): Promise<void> {
     if (!('serial' in navigator)) {
@@ -27,6 +31,16 @@ export class SerialDevice {
         this.writer = this.port.writable.getWriter();
       }
 
+      // Device state is unknown after (re)connecting
+      this.encoder.reset();
+
+      // Credit reports from the firmware pace the frames sent
+      if (this.port.readable) {
+        this.reader = this.port.readable.getReader();
+        void this.readLoop(this.reader);
+      }
+      await this.probeCredits();
+
       console.log('Connected to serial device');
     } catch (error) {
       console.error('Failed to connect:', error);
@@ -34,6 +48,33 @@ export class SerialDevice {
     }
   }
 
+  /**
+   * Reset the device's frame count; it answers with a credit report
+   */
+  private async probeCredits(): Promise<void> {
+    this.credits.reset();
+    await this.writer?.write(framePacket(buildCredit(0)));
+  }
+
+  /**
+   * Feed everything the device sends to the credit counter until cancelled
+   */
+  private async readLoop(reader: ReadableStreamDefaultReader<Uint8Array>): Promise<void> {
+    try {
+      for (;;) {
+        const { value, done } = await reader.read();
+        if (done) {
+          break;
+        }
+        if (value) {
+          this.credits.feed(value);
+        }
+      }
+    } catch (error) {
+      console.error('Serial read failed:', error);
+    }
+  }
+
   async disconnect(): Promise<void> {
     if (this.writer) {
       this.writer.releaseLock();
@@ -41,6 +82,7 @@ export class SerialDevice {
     }
 
     if (this.reader) {
+      await this.reader.cancel();
       this.reader.releaseLock();
       this.reader = null;
     }
@@ -57,63 +99,8 @@ export class SerialDevice {
     return this.port !== null && this.writer !== null;
   }
 
-  /**
-   * Convert RGBA ImageData to RGB565 format
-   */
-  private imageDataToRGB565(imageData: ImageData): Uint8Array {
-    const { data, width, height } = imageData;
-    const rgb565 = new Uint8Array(width * height * 2);
-
-    for (let y = 0; y < height; y++) {
-      for (let x = 0; x < width; x++) {
-        const i = (y * width + x) * 4;
-        const r = data[i] >> 3;     // 8-bit to 5-bit
-        const g = data[i + 1] >> 2; // 8-bit to 6-bit
-        const b = data[i + 2] >> 3; // 8-bit to 5-bit
-
-        const rgb565Value = (r << 11) | (g << 5) | b;
-
-        // Little-endian
-        const outputIndex = (y * width + x) * 2;
-        rgb565[outputIndex] = rgb565Value & 0xFF;
-        rgb565[outputIndex + 1] = (rgb565Value >> 8) & 0xFF;
-      }
-    }
-
-    return rgb565;
-  }
-
-  /**
-   * Resize and flip image to display dimensions
-   */
-  private prepareImage(imageData: ImageData): ImageData {
-    const canvas = document.createElement('canvas');
-    canvas.width = DISPLAY_WIDTH;
-    canvas.height = DISPLAY_HEIGHT;
-    const ctx = canvas.getContext('2d')!;
-
-    // Draw and resize image
-    ctx.drawImage(
-      createImageBitmap(imageData) as any,
-      0,
-      0,
-      imageData.width,
-      imageData.height,
-      0,
-      0,
-      DISPLAY_WIDTH,
-      DISPLAY_HEIGHT
-    );
-
-    // Horizontal flip for HUB75 shift register order
-    const flippedCanvas = document.createElement('canvas');
-    flippedCanvas.width = DISPLAY_WIDTH;
-    flippedCanvas.height = DISPLAY_HEIGHT;
-    const flippedCtx = flippedCanvas.getContext('2d')!;
-    flippedCtx.scale(-1, 1);
-    flippedCtx.drawImage(canvas, -DISPLAY_WIDTH, 0);
-
-    return flippedCtx.getImageData(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+  isPaced(): boolean {
+    return this.credits.isEnabled();
   }
 
   /**
@@ -125,41 +112,49 @@ export class SerialDevice {
 
   /**
    * Send a frame to the display
-   * Returns false if already sending (frame drop) or on error
+   * Returns false if already sending or the device has no free frame slot
+   * (frame drop), or on error
    */
-  async sendFrame(imageData: ImageData): Promise<boolean> {
+  async sendFrame(source: FrameSource): Promise<boolean> {
     if (!this.writer) {
       throw new Error('Not connected to serial device');
     }
 
-    // Frame drop: skip if previous send is still in progress
-    if (this.sending) {
+    // Frame drop: skip if previous send is still in progress or the
+    // device has not yet consumed the frames in flight
+    if (this.sending || !this.credits.canSend()) {
+      if (!this.sending && this.credits.isStalled()) {
+        // Counts out of step (lost report, dropped packet): start over
+        this.probeCredits().catch((error) => {
+          console.error('Failed to re-sync credits:', error);
+        });
+      }
+      FrameEncoder.discard(source);
       return false;
     }
 
     this.sending = true;
 
     try {
-      // Prepare image (resize and flip)
-      const prepared = this.prepareImage(imageData);
-
-      // Convert to RGB565
-      const rgb565Data = this.imageDataToRGB565(prepared);
-
-      // COBS encode
-      const encoded = cobsEncode(rgb565Data);
-
-      // Add terminator
-      const packet = new Uint8Array(encoded.length + 1);
-      packet.set(encoded, 0);
-      packet[encoded.length] = 0x00;
+      // Resize, flip, convert to RGB565 and encode the smallest update
+      // relative to the last frame sent, on the encoder worker
+      const packet = await this.encoder.encode(source);
+      if (packet === null) {
+        return true; // Unchanged frame
+      }
 
-      // Send
-      await this.writer.write(packet);
+      // COBS packet with terminator, then its buffer goes back to the worker
+      try {
+        await this.writer.write(packet);
+      } finally {
+        this.encoder.release(packet);
+      }
+      this.credits.onSent();
 
       return true;
     } catch (error) {
       console.error('Failed to send frame:', error);
+      this.encoder.reset();
       return false;
     } finally {
       this.sending = false;
@@ -0,0 +1,192 @@
+import { framePacket, type FrameSource } from './frame';
+import { FrameEncoder } from './frameEncoder';
+import { FrameCredits, buildCredit } from './protocol';
+import type { LEDMatrixController } from '../types';
+
+// Raspberry Pi USB vendor ID (RP2040 default)
+const RP2040_VENDOR_ID = 0x2E8A;
+
+// Vendor-specific interface class
+const USB_CLASS_VENDOR = 0xFF;
+
+/**
+ * WebUSB wrapper for the firmware's vendor (bulk) interface
+ * Requires firmware built with HUB75_USE_VENDOR=1 (env: pico_webusb).
+ * Packets are identical to the serial transport.
+ */
+export class WebUSBDevice implements LEDMatrixController {
+  private device: USBDevice | null = null;
+  private interfaceNumber = -1;
+  private endpointNumber = -1;
+  private inEndpointNumber = -1;
+  private sending: boolean = false;
+  private encoder = new FrameEncoder();
+  private credits = new FrameCredits();
+
+  async connect(): Promise<void> {
+    if (!('usb' in navigator)) {
+      throw new Error('WebUSB API is not supported in this browser');
+    }
+
+    try {
+      // Request device from user
+      const device = await navigator.usb.requestDevice({
+        filters: [{ vendorId: RP2040_VENDOR_ID, classCode: USB_CLASS_VENDOR }],
+      });
+
+      await device.open();
+      if (device.configuration === null) {
+        await device.selectConfiguration(1);
+      }
+
+      // Find the vendor interface and its bulk OUT endpoint
+      for (const intf of device.configuration!.interfaces) {
+        const alt = intf.alternate;
+        if (alt.interfaceClass !== USB_CLASS_VENDOR) {
+          continue;
+        }
+        const ep = alt.endpoints.find((e) => e.direction === 'out' && e.type === 'bulk');
+        if (ep) {
+          const epIn = alt.endpoints.find((e) => e.direction === 'in' && e.type === 'bulk');
+          this.interfaceNumber = intf.interfaceNumber;
+          this.endpointNumber = ep.endpointNumber;
+          this.inEndpointNumber = epIn ? epIn.endpointNumber : -1;
+          break;
+        }
+      }
+
+      if (this.endpointNumber < 0) {
+        await device.close();
+        throw new Error('No vendor bulk interface found (firmware: pico_webusb)');
+      }
+
+      await device.claimInterface(this.interfaceNumber);
+      this.device = device;
+
+      // Device state is unknown after (re)connecting
+      this.encoder.reset();
+
+      // Credit reports from the firmware pace the frames sent
+      this.credits.reset();
+      if (this.inEndpointNumber >= 0) {
+        void this.readLoop(device);
+        await this.probeCredits();
+      }
+
+      console.log('Connected to WebUSB device');
+    } catch (error) {
+      console.error('Failed to connect:', error);
+      this.interfaceNumber = -1;
+      this.endpointNumber = -1;
+      this.inEndpointNumber = -1;
+      throw error;
+    }
+  }
+
+  /**
+   * Reset the device's frame count; it answers with a credit report
+   */
+  private async probeCredits(): Promise<void> {
+    this.credits.reset();
+    await this.device?.transferOut(this.endpointNumber, framePacket(buildCredit(0)));
+  }
+
+  /**
+   * Feed everything the device sends to the credit counter until it closes
+   */
+  private async readLoop(device: USBDevice): Promise<void> {
+    try {
+      while (this.device === device && device.opened) {
+        const result = await device.transferIn(this.inEndpointNumber, 64);
+        if (result.data) {
+          this.credits.feed(new Uint8Array(result.data.buffer, result.data.byteOffset, result.data.byteLength));
+        }
+      }
+    } catch {
+      // Device closed or disconnected
+    }
+  }
+
+  async disconnect(): Promise<void> {
+    if (this.device) {
+      await this.device.releaseInterface(this.interfaceNumber);
+      await this.device.close();
+      this.device = null;
+    }
+    this.interfaceNumber = -1;
+    this.endpointNumber = -1;
+    this.inEndpointNumber = -1;
+
+    console.log('Disconnected from WebUSB device');
+  }
+
+  isConnected(): boolean {
+    return this.device !== null && this.device.opened;
+  }
+
+  isPaced(): boolean {
+    return this.credits.isEnabled();
+  }
+
+  /**
+   * Check if currently sending a frame
+   */
+  isSending(): boolean {
+    return this.sending;
+  }
+
+  /**
+   * Send a frame to the display
+   * Returns false if already sending or the device has no free frame slot
+   * (frame drop), or on error
+   */
+  async sendFrame(source: FrameSource): Promise<boolean> {
+    if (!this.device) {
+      throw new Error('Not connected to WebUSB device');
+    }
+
+    // Frame drop: skip if previous send is still in progress or the
+    // device has not yet consumed the frames in flight
+    if (this.sending || !this.credits.canSend()) {
+      if (!this.sending && this.credits.isStalled()) {
+        // Counts out of step (lost report, dropped packet): start over
+        this.probeCredits().catch((error) => {
+          console.error('Failed to re-sync credits:', error);
+        });
+      }
+      FrameEncoder.discard(source);
+      return false;
+    }
+
+    this.sending = true;
+
+    try {
+      // Resize, flip, convert to RGB565 and encode the smallest update
+      // relative to the last frame sent, on the encoder worker
+      const packet = await this.encoder.encode(source);
+      if (packet === null) {
+        return true; // Unchanged frame
+      }
+
+      // One bulk transfer per packet, then its buffer goes back to the worker
+      let result: USBOutTransferResult;
+      try {
+        result = await this.device.transferOut(this.endpointNumber, packet);
+      } finally {
+        this.encoder.release(packet);
+      }
+      if (result.status !== 'ok') {
+        throw new Error(`transferOut: ${result.status}`);
+      }
+      this.credits.onSent();
+
+      return true;
+    } catch (error) {
+      console.error('Failed to send frame:', error);
+      this.encoder.reset();
+      return false;
+    } finally {
+      this.sending = false;
+    }
+  }
+}
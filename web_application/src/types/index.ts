@@ -1,3 +1,5 @@
+import type { FrameSource } from '../lib/frame';
+
 export const DISPLAY_WIDTH = 128;
 export const DISPLAY_HEIGHT = 32;
 
@@ -10,6 +12,8 @@ export interface SerialDeviceOptions {
 export interface LEDMatrixController {
   connect(): Promise<void>;
   disconnect(): Promise<void>;
-  sendFrame(imageData: ImageData): Promise<boolean>;
+  sendFrame(source: FrameSource): Promise<boolean>;
   isConnected(): boolean;
+  // True once the device paces frames with credit reports (see FrameCredits)
+  isPaced(): boolean;
 }
@@ -0,0 +1,58 @@
+/**
+ * Minimal WebUSB typings (the subset used by lib/webusb.ts)
+ */
+interface USBDeviceFilter {
+  vendorId?: number;
+  productId?: number;
+  classCode?: number;
+}
+
+interface USBEndpoint {
+  endpointNumber: number;
+  direction: 'in' | 'out';
+  type: 'bulk' | 'interrupt' | 'isochronous';
+}
+
+interface USBAlternateInterface {
+  interfaceClass: number;
+  endpoints: USBEndpoint[];
+}
+
+interface USBInterface {
+  interfaceNumber: number;
+  alternate: USBAlternateInterface;
+}
+
+interface USBConfiguration {
+  interfaces: USBInterface[];
+}
+
+interface USBOutTransferResult {
+  bytesWritten: number;
+  status: 'ok' | 'stall' | 'babble';
+}
+
+interface USBInTransferResult {
+  data?: DataView;
+  status: 'ok' | 'stall' | 'babble';
+}
+
+interface USBDevice {
+  readonly opened: boolean;
+  readonly configuration: USBConfiguration | null;
+  open(): Promise<void>;
+  close(): Promise<void>;
+  selectConfiguration(configurationValue: number): Promise<void>;
+  claimInterface(interfaceNumber: number): Promise<void>;
+  releaseInterface(interfaceNumber: number): Promise<void>;
+  transferOut(endpointNumber: number, data: BufferSource): Promise<USBOutTransferResult>;
+  transferIn(endpointNumber: number, length: number): Promise<USBInTransferResult>;
+}
+
+interface USB {
+  requestDevice(options: { filters: USBDeviceFilter[] }): Promise<USBDevice>;
+}
+
+interface Navigator {
+  readonly usb: USB;
+}